@@ -0,0 +1,186 @@
+// Expression evaluator benchmark: interpreter vs JIT on the surfaces listed
+// in test-functions-3d.md, each sampled on a 500x500 grid over [-5, 5]^2.
+// Every sample of the JIT and SIMD batch paths is first checked against
+// the scalar interpreter; any difference makes the exit status non-zero.
+// No SFML needed:  g++ -std=c++17 -O2 bench.cpp -o bench && ./bench
+// An optional argument names a different Markdown file.
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "jit.hpp"
+
+// Every non-empty line inside a ``` block is one expression.
+static std::vector<std::string> loadCorpus(const char* path) {
+    std::vector<std::string> out;
+    std::ifstream f(path);
+    std::string line;
+    bool inBlock = false;
+    while (std::getline(f, line)) {
+        if (line.compare(0, 3, "```") == 0) { inBlock = !inBlock; continue; }
+        if (inBlock && line.find_first_not_of(" \t\r") != std::string::npos) out.push_back(line);
+    }
+    return out;
+}
+
+template <typename F>
+static double nsPerSample(F run, size_t samples) {
+    // Repeat until at least 50 ms have elapsed, keep the per-sample time.
+    int reps = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        run();
+        reps++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (elapsed < 0.05);
+    return elapsed / reps / samples * 1e9;
+}
+
+// Equal up to a few ulps of the larger magnitude, or both NaN. Values
+// that cancel to near zero are compared against an absolute floor.
+static bool sameValue(double a, double b) {
+    if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+    if (a == b) return true;
+    if (std::isinf(a) || std::isinf(b)) return false;
+    double scale = std::max(std::fabs(a), std::fabs(b));
+    return std::fabs(a - b) <= std::max(8 * scale * DBL_EPSILON, 1e-13);
+}
+
+// Compares jit.eval, evalBatch and jit.evalBatch with parser.eval on every
+// sample; prints the first few differences and returns their count.
+static int checkPaths(const Parser& parser, const Program& prog, const JitProgram& jit, const std::string& expr,
+                      const std::vector<double>& xs, const std::vector<double>& ys) {
+    size_t n = xs.size();
+    std::vector<double> batch(n), jitBatch(n);
+    std::vector<uint8_t> batchOk(n), jitBatchOk(n);
+    parser.evalBatch(prog, xs.data(), ys.data(), batch.data(), batchOk.data(), n);
+    jit.evalBatch(xs.data(), ys.data(), jitBatch.data(), jitBatchOk.data(), n);
+    int mismatches = 0;
+    auto report = [&](const char* path, size_t i, double want, bool wantOk, double got, bool gotOk) {
+        if (gotOk == wantOk && (!wantOk || sameValue(want, got))) return;
+        if (mismatches++ < 5)
+            printf("  %s: %s(%g, %g) = %.17g%s, seharusnya %.17g%s\n", expr.c_str(), path, xs[i], ys[i], got,
+                   gotOk ? "" : " (tak terdefinisi)", want, wantOk ? "" : " (tak terdefinisi)");
+    };
+    for (size_t i = 0; i < n; i++) {
+        bool ok, jitOk;
+        double want = parser.eval(prog, xs[i], ys[i], ok);
+        double got = jit.eval(xs[i], ys[i], jitOk);
+        report("jit", i, want, ok, got, jitOk);
+        report("batch", i, want, ok, batch[i], batchOk[i] != 0);
+        report("jit-batch", i, want, ok, jitBatch[i], jitBatchOk[i] != 0);
+    }
+    if (mismatches > 5) printf("  %s: %d selisih\n", expr.c_str(), mismatches);
+    return mismatches;
+}
+
+// Known enclosures that the interval culling relies on; prints each miss.
+static int checkIntervals(const Parser& parser) {
+    struct Case {
+        const char* expr;
+        Interval x, y;
+        double lo, hi;
+    };
+    const Case cases[] = {
+        {"x^2", {-1, 1}, Interval::point(0), 0, 1},
+        {"x^2+y^2-4", {-1, 1}, {-1, 1}, -4, -2},
+        {"(x-1)^2", {0, 2}, Interval::point(0), 0, 1},
+    };
+    int failed = 0;
+    for (const Case& c : cases) {
+        Program prog;
+        std::string err;
+        if (!parser.compile(c.expr, prog, err)) {
+            printf("interval %s: %s\n", c.expr, err.c_str());
+            failed++;
+            continue;
+        }
+        Interval v = parser.evalInterval(prog, c.x, c.y);
+        if (v.lo != c.lo || v.hi != c.hi) {
+            printf("interval %s: [%g, %g], seharusnya [%g, %g]\n", c.expr, v.lo, v.hi, c.lo, c.hi);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "test-functions-3d.md";
+    std::vector<std::string> corpus = loadCorpus(path);
+    if (corpus.empty()) {
+        fprintf(stderr, "Tidak ada ekspresi di %s\n", path);
+        return 1;
+    }
+
+    const int N = 500;
+    std::vector<double> xs, ys;
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++) {
+            xs.push_back(-5 + 10.0 * i / (N - 1));
+            ys.push_back(-5 + 10.0 * j / (N - 1));
+        }
+    size_t n = xs.size();
+    std::vector<double> out(n);
+    std::vector<uint8_t> ok(n);
+    volatile double sink = 0;
+
+    Parser parser;
+    int failed = checkIntervals(parser);
+    printf("SIMD: %s, JIT: %s\n\n", simdKernels().isa, JitProgram::available() ? "ya" : "tidak");
+    printf("%-46s %9s %9s %9s %9s  (ns/sampel)\n", "ekspresi", "eval", "jit", "batch", "jit-batch");
+
+    double total[4] = {0, 0, 0, 0};
+    int counted = 0;
+    for (const std::string& expr : corpus) {
+        Program prog;
+        std::string err;
+        if (!parser.compile(expr, prog, err)) {
+            printf("%-46s %s\n", expr.c_str(), err.c_str());
+            continue;
+        }
+        JitProgram jit;
+        bool native = jit.compile(prog);
+
+        // Every sample of every path against the scalar interpreter, the
+        // reference for both the JIT encoder and the SIMD kernels.
+        int mismatches = checkPaths(parser, prog, jit, expr, xs, ys);
+        if (mismatches) failed++;
+
+        double t[4];
+        t[0] = nsPerSample([&] {
+            double s = 0;
+            bool k;
+            for (size_t i = 0; i < n; i++) s += parser.eval(prog, xs[i], ys[i], k);
+            sink = s;
+        }, n);
+        t[1] = nsPerSample([&] {
+            double s = 0;
+            bool k;
+            for (size_t i = 0; i < n; i++) s += jit.eval(xs[i], ys[i], k);
+            sink = s;
+        }, n);
+        t[2] = nsPerSample([&] { parser.evalBatch(prog, xs.data(), ys.data(), out.data(), ok.data(), n); }, n);
+        t[3] = nsPerSample([&] { jit.evalBatch(xs.data(), ys.data(), out.data(), ok.data(), n); }, n);
+
+        printf("%-46s %9.2f %9.2f %9.2f %9.2f%s\n", expr.c_str(), t[0], t[1], t[2], t[3],
+               native ? "" : "  (interpreter)");
+        for (int k = 0; k < 4; k++) total[k] += t[k];
+        counted++;
+    }
+
+    printf("\n%-46s %9.2f %9.2f %9.2f %9.2f\n", "rata-rata", total[0] / counted, total[1] / counted,
+           total[2] / counted, total[3] / counted);
+    printf("JIT vs eval: %.2fx, JIT batch vs batch: %.2fx\n", total[0] / total[1], total[2] / total[3]);
+    if (failed) {
+        fprintf(stderr, "%d pemeriksaan gagal\n", failed);
+        return 1;
+    }
+    return 0;
+}
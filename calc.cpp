@@ -0,0 +1,259 @@
+// Batch evaluator: writes f(x) for one or more expressions over a range of
+// x, or over x values read from stdin, as CSV or raw binary columns.
+// No SFML needed:  g++ -std=c++17 -O2 -pthread calc.cpp -o calc
+//
+//   calc -x 0:10:0.001 "sin(x)" "x^2"      range with step, ends included
+//   seq 1 100 | calc "sqrt(x)"             x values from stdin
+//   calc -b -x 0:1e8:1 -o out.bin "exp(-x)"
+//
+// Every row holds x followed by one value per expression; undefined values
+// are nan. CSV starts with a header row. -b writes each row as native
+// doubles instead, without a header. Rows are evaluated in blocks through
+// the JIT batch path on every core and formatted into per-chunk buffers
+// that go out with one fwrite each.
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "jit.hpp"
+#include "pool.hpp"
+
+// Rows per block (evaluated, then written) and per pool task.
+static const size_t BLOCK_ROWS = 1 << 18;
+static const size_t CHUNK_ROWS = 4096;
+
+// Shortest text that reads back as the same double.
+static char* formatValue(char* p, char* end, double v) {
+    if (std::isnan(v)) {
+        memcpy(p, "nan", 3);
+        return p + 3;
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    return std::to_chars(p, end, v).ptr;
+#else
+    return p + snprintf(p, size_t(end - p), "%.17g", v);
+#endif
+}
+
+static bool parseValue(const char* begin, const char* end, double& v) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    return std::from_chars(begin, end, v).ptr == end;
+#else
+    std::string s(begin, end);
+    char* stop;
+    v = strtod(s.c_str(), &stop);
+    return *stop == '\0';
+#endif
+}
+
+// Reads up to max x values from f into xs, separated by whitespace or
+// commas, through the caller's read buffer buf. Unread input, including a
+// token cut off at the end of buf, stays in pending for the next call.
+// False on a malformed value.
+static bool readValues(FILE* f, std::vector<char>& buf, std::string& pending, std::vector<double>& xs, size_t max) {
+    xs.clear();
+    auto separator = [](char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ','; };
+    bool eof = false;
+    for (;;) {
+        const char* p = pending.data();
+        const char* last = p + pending.size();
+        // Before end of input only tokens followed by a separator are whole.
+        if (!eof)
+            while (last > p && !separator(last[-1])) last--;
+        while (p < last && xs.size() < max) {
+            while (p < last && separator(*p)) p++;
+            const char* b = p;
+            while (p < last && !separator(*p)) p++;
+            if (p == b) continue;
+            double v;
+            if (!parseValue(b, p, v)) {
+                fprintf(stderr, "Nilai x tidak valid: %.*s\n", int(p - b), b);
+                return false;
+            }
+            xs.push_back(v);
+        }
+        pending.erase(0, size_t(p - pending.data()));
+        if (xs.size() >= max || eof) return true;
+        size_t got = fread(buf.data(), 1, buf.size(), f);
+        if (got == 0) eof = true;
+        pending.append(buf.data(), got);
+    }
+}
+
+struct Column {
+    std::string expr;
+    JitProgram jit;
+};
+
+// Evaluates and writes one block of rows. Each chunk of rows is evaluated
+// and formatted by one task into its own buffer; the buffers are then
+// written in order.
+class BlockWriter {
+public:
+    BlockWriter(const std::vector<Column>& columns, bool binary, ThreadPool& pool, FILE* out)
+        : columns(columns), binary(binary), pool(pool), out(out),
+          values(columns.size() * BLOCK_ROWS), ok(columns.size() * BLOCK_ROWS),
+          text(BLOCK_ROWS / CHUNK_ROWS), used(BLOCK_ROWS / CHUNK_ROWS) {
+        // Per row: x and every column, each at most 24 characters plus a
+        // separator, or one double in binary.
+        size_t rowBytes = binary ? (columns.size() + 1) * sizeof(double) : (columns.size() + 1) * 32;
+        for (std::vector<char>& t : text) t.resize(CHUNK_ROWS * rowBytes);
+    }
+
+    bool write(const double* xs, size_t n) {
+        size_t chunks = (n + CHUNK_ROWS - 1) / CHUNK_ROWS;
+        pool.parallelFor(chunks, 1, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; c++) emitChunk(xs, c * CHUNK_ROWS, std::min(n, (c + 1) * CHUNK_ROWS), c);
+        });
+        for (size_t c = 0; c < chunks; c++)
+            if (fwrite(text[c].data(), 1, used[c], out) != used[c]) return false;
+        return true;
+    }
+
+private:
+    void emitChunk(const double* xs, size_t r0, size_t r1, size_t c) {
+        size_t n = r1 - r0, m = columns.size();
+        for (size_t j = 0; j < m; j++)
+            columns[j].jit.evalBatch(xs + r0, &values[j * BLOCK_ROWS + r0], &ok[j * BLOCK_ROWS + r0], n);
+        char* p = text[c].data();
+        char* end = p + text[c].size();
+        for (size_t r = r0; r < r1; r++) {
+            if (binary) {
+                memcpy(p, &xs[r], sizeof(double));
+                p += sizeof(double);
+            } else {
+                p = formatValue(p, end, xs[r]);
+            }
+            for (size_t j = 0; j < m; j++) {
+                double v = ok[j * BLOCK_ROWS + r] ? values[j * BLOCK_ROWS + r] : NAN;
+                if (binary) {
+                    memcpy(p, &v, sizeof(double));
+                    p += sizeof(double);
+                } else {
+                    *p++ = ',';
+                    p = formatValue(p, end, v);
+                }
+            }
+            if (!binary) *p++ = '\n';
+        }
+        used[c] = size_t(p - text[c].data());
+    }
+
+    const std::vector<Column>& columns;
+    bool binary;
+    ThreadPool& pool;
+    FILE* out;
+    std::vector<double> values;
+    std::vector<uint8_t> ok;
+    std::vector<std::vector<char>> text;
+    std::vector<size_t> used;
+};
+
+static int usage() {
+    fprintf(stderr,
+            "Pemakaian: calc [-x awal:akhir:langkah] [-b] [-j thread] [-o file] ekspresi...\n"
+            "           tanpa -x, nilai x dibaca dari stdin\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> exprs;
+    const char* outPath = nullptr;
+    bool binary = false, range = false;
+    double x0 = 0, x1 = 0, step = 0;
+    size_t count = 0;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(a, "-b")) binary = true;
+        else if (!strcmp(a, "-o") && hasValue) outPath = argv[++i];
+        else if (!strcmp(a, "-j") && hasValue) threads = unsigned(atoi(argv[++i]));
+        else if (!strcmp(a, "-x") && hasValue) {
+            range = true;
+            if (sscanf(argv[++i], "%lf:%lf:%lf", &x0, &x1, &step) != 3 || !(step > 0) || !(x1 >= x0)) return usage();
+            // Row indices past 2^53 are not exact doubles, and an infinite or NaN
+            // span has no row count at all.
+            double steps = std::floor((x1 - x0) / step * (1 + 1e-12));
+            if (!std::isfinite(steps) || steps >= 9007199254740992.0) return usage();
+            count = size_t(steps) + 1;
+        } else {
+            exprs.push_back(a);
+        }
+    }
+    if (exprs.empty()) return usage();
+
+    Parser parser;
+    std::vector<Column> columns;
+    for (const std::string& e : exprs) {
+        std::string err;
+        Program prog;
+        auto t = parser.parse(e, err);
+        if (err.empty()) prog = parser.toRPN(t, err);
+        if (err.empty() && prog.usesY) err = "Variabel y tidak didukung, hanya x";
+        if (err.empty() && prog.empty()) err = "Ekspresi kosong";
+        if (!err.empty()) {
+            fprintf(stderr, "'%s': %s\n", e.c_str(), err.c_str());
+            return 1;
+        }
+        columns.push_back({e, JitProgram()});
+        columns.back().jit.compile(prog);
+    }
+
+    FILE* out = outPath ? fopen(outPath, binary ? "wb" : "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Tidak bisa membuka %s\n", outPath);
+        return 1;
+    }
+    if (!binary) {
+        // Expressions with commas or quotes are quoted as CSV fields.
+        std::string header = "x";
+        for (const Column& c : columns) {
+            header += ',';
+            if (c.expr.find_first_of(",\"") == std::string::npos) {
+                header += c.expr;
+                continue;
+            }
+            header += '"';
+            for (char ch : c.expr) header += ch == '"' ? std::string("\"\"") : std::string(1, ch);
+            header += '"';
+        }
+        header += '\n';
+        fputs(header.c_str(), out);
+    }
+
+    ThreadPool pool(threads);
+    BlockWriter writer(columns, binary, pool, out);
+    std::vector<double> xs;
+    xs.reserve(BLOCK_ROWS);
+    bool ok = true;
+    if (range) {
+        // x_i = x0 + i * step, so long ranges do not accumulate rounding.
+        for (size_t first = 0; ok && first < count; first += BLOCK_ROWS) {
+            size_t n = std::min(BLOCK_ROWS, count - first);
+            xs.resize(n);
+            for (size_t i = 0; i < n; i++) xs[i] = x0 + double(first + i) * step;
+            ok = writer.write(xs.data(), n);
+        }
+    } else {
+        std::vector<char> buf(1 << 20);
+        std::string pending;
+        for (;;) {
+            if (!readValues(stdin, buf, pending, xs, BLOCK_ROWS)) {
+                ok = false;
+                break;
+            }
+            if (xs.empty()) break;
+            if (!(ok = writer.write(xs.data(), xs.size()))) break;
+        }
+    }
+    if (fflush(out) != 0) ok = false;
+    if (outPath && fclose(out) != 0) ok = false;
+    if (!ok) return 1;
+    return 0;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "simd.hpp"
+
+// ============================================================================
+// KAMERA - matriks view-projection 4x4 dan proyeksi batch
+// ============================================================================
+
+// Maps world (x, y, z, 1) to (X, Y, depth, W); the screen point is
+// (X / W, Y / W). Built once per frame, so the trigonometry runs once
+// rather than per vertex. Row 2 is the view-space depth (larger is
+// further away), used for ordering.
+struct Camera {
+    float m[4][4];
+
+    // The grapher's orbit camera: rotate about y, then about x, divide by
+    // 1 + depth / distance and place at origin with scale px per unit
+    // (screen y grows downwards).
+    static Camera orbit(float rotX, float rotY, float scale, float originX, float originY,
+                        float distance = 15) {
+        float cx = std::cos(rotX), sx = std::sin(rotX);
+        float cy = std::cos(rotY), sy = std::sin(rotY);
+        // Rows of Rx * Ry: right, up and depth axes in world coordinates.
+        const float right[3] = {cy, 0, -sy};
+        const float up[3] = {-sx * sy, cx, -sx * cy};
+        const float depth[3] = {cx * sy, sx, cx * cy};
+        Camera c;
+        for (int k = 0; k < 3; k++) {
+            float w = depth[k] / distance;
+            c.m[0][k] = scale * right[k] + originX * w;
+            c.m[1][k] = -scale * up[k] + originY * w;
+            c.m[2][k] = depth[k];
+            c.m[3][k] = w;
+        }
+        c.m[0][3] = originX;
+        c.m[1][3] = originY;
+        c.m[2][3] = 0;
+        c.m[3][3] = 1;
+        return c;
+    }
+
+    void project(float x, float y, float z, float& sx, float& sy) const {
+        float w = 1 / (m[3][0] * x + m[3][1] * y + m[3][2] * z + m[3][3]);
+        sx = (m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3]) * w;
+        sy = (m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3]) * w;
+    }
+
+    float depth(float x, float y, float z) const {
+        return m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+    }
+
+    // Projects n points given as separate x/y/z arrays into sx/sy.
+    void projectBatch(const float* xs, const float* ys, const float* zs, float* sx, float* sy,
+                      size_t n) const;
+};
+
+// ----------------------------------------------------------------------------
+// Batch kernels, one per instruction set like the column kernels in simd.hpp
+// ----------------------------------------------------------------------------
+
+namespace camera_scalar {
+
+inline void projectBatch(const Camera& c, const float* xs, const float* ys, const float* zs, float* sx,
+                         float* sy, size_t n) {
+    for (size_t i = 0; i < n; i++) c.project(xs[i], ys[i], zs[i], sx[i], sy[i]);
+}
+
+} // namespace camera_scalar
+
+#ifdef SIMD_X86
+
+namespace camera_sse2 {
+
+inline void projectBatch(const Camera& c, const float* xs, const float* ys, const float* zs, float* sx,
+                         float* sy, size_t n) {
+    __m128 m[4][4];
+    for (int r = 0; r < 4; r++)
+        for (int k = 0; k < 4; k++) m[r][k] = _mm_set1_ps(c.m[r][k]);
+    auto row = [&](int r, __m128 x, __m128 y, __m128 z) {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[r][0], x), _mm_mul_ps(m[r][1], y)),
+                          _mm_add_ps(_mm_mul_ps(m[r][2], z), m[r][3]));
+    };
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(xs + i), y = _mm_loadu_ps(ys + i), z = _mm_loadu_ps(zs + i);
+        __m128 w = _mm_div_ps(_mm_set1_ps(1), row(3, x, y, z));
+        _mm_storeu_ps(sx + i, _mm_mul_ps(row(0, x, y, z), w));
+        _mm_storeu_ps(sy + i, _mm_mul_ps(row(1, x, y, z), w));
+    }
+    camera_scalar::projectBatch(c, xs + i, ys + i, zs + i, sx + i, sy + i, n - i);
+}
+
+} // namespace camera_sse2
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace camera_avx2 {
+
+inline void projectBatch(const Camera& c, const float* xs, const float* ys, const float* zs, float* sx,
+                         float* sy, size_t n) {
+    __m256 m[4][4];
+    for (int r = 0; r < 4; r++)
+        for (int k = 0; k < 4; k++) m[r][k] = _mm256_set1_ps(c.m[r][k]);
+    auto row = [&](int r, __m256 x, __m256 y, __m256 z) {
+        return _mm256_fmadd_ps(m[r][0], x, _mm256_fmadd_ps(m[r][1], y, _mm256_fmadd_ps(m[r][2], z, m[r][3])));
+    };
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(xs + i), y = _mm256_loadu_ps(ys + i), z = _mm256_loadu_ps(zs + i);
+        __m256 w = _mm256_div_ps(_mm256_set1_ps(1), row(3, x, y, z));
+        _mm256_storeu_ps(sx + i, _mm256_mul_ps(row(0, x, y, z), w));
+        _mm256_storeu_ps(sy + i, _mm256_mul_ps(row(1, x, y, z), w));
+    }
+    camera_sse2::projectBatch(c, xs + i, ys + i, zs + i, sx + i, sy + i, n - i);
+}
+
+} // namespace camera_avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // SIMD_X86
+
+inline void Camera::projectBatch(const float* xs, const float* ys, const float* zs, float* sx, float* sy,
+                                 size_t n) const {
+#ifdef SIMD_X86
+    static const bool avx2 = cpuHasAvx2();
+    if (avx2) camera_avx2::projectBatch(*this, xs, ys, zs, sx, sy, n);
+    else camera_sse2::projectBatch(*this, xs, ys, zs, sx, sy, n);
+#else
+    camera_scalar::projectBatch(*this, xs, ys, zs, sx, sy, n);
+#endif
+}
@@ -2,201 +2,66 @@
 #include <cmath>
 #include <string>
 #include <vector>
-#include <map>
-#include <functional>
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <memory>
+
+#include "jit.hpp"
+#include "pool.hpp"
+#include "samples.hpp"
+#include "vector.hpp"
 
 // ============================================================================
 // STRUKTUR DATA
 // ============================================================================
 
-struct Token {
-    enum Type { NUMBER, VAR_X, OP, FUNC, LPAREN, RPAREN } type;
-    double value{};
-    std::string text;
-    int precedence{};
-    bool rightAssoc{};
-};
+// Screen mapping: screen = origin + (x, -y) * scale.
+struct GraphView {
+    sf::Vector2f origin;
+    float scale = 0;
+    sf::Vector2u windowSize;
 
-struct Function {
-    std::string expr;
-    std::vector<Token> rpn;
-    sf::Color color;
-    bool visible = true;
-    bool showDerivative = false;
+    bool operator==(const GraphView& v) const {
+        return origin == v.origin && scale == v.scale && windowSize == v.windowSize;
+    }
+    bool operator!=(const GraphView& v) const { return !(*this == v); }
 };
 
-// ============================================================================
-// PARSER - Parsing dan Evaluasi Ekspresi
-// ============================================================================
+// Sampled columns and ready-to-draw strips of one function. The strips are
+// valid for the view they were built for; the column rings survive pans
+// and only evaluate newly exposed pixels. A Function's expression never
+// changes after compile, so a new entry simply starts with an empty cache.
+// Only the background evaluation job touches it.
+struct CurveCache {
+    bool valid = false;
+    GraphView view;
+    bool derivative = false;
 
-class Parser {
-    std::map<std::string, std::function<double(double)>> funcs;
-    
-public:
-    Parser() {
-        funcs = {
-            {"sin", [](double x) { return sin(x); }},
-            {"cos", [](double x) { return cos(x); }},
-            {"tan", [](double x) { return tan(x); }},
-            {"asin", [](double x) { return asin(x); }},
-            {"acos", [](double x) { return acos(x); }},
-            {"atan", [](double x) { return atan(x); }},
-            {"sinh", [](double x) { return sinh(x); }},
-            {"cosh", [](double x) { return cosh(x); }},
-            {"tanh", [](double x) { return tanh(x); }},
-            {"exp", [](double x) { return exp(x); }},
-            {"ln", [](double x) { return log(x); }},
-            {"log", [](double x) { return log10(x); }},
-            {"sqrt", [](double x) { return sqrt(x); }},
-            {"abs", [](double x) { return fabs(x); }},
-            {"floor", [](double x) { return floor(x); }},
-            {"ceil", [](double x) { return ceil(x); }}
-        };
-    }
+    ColumnSamples f, df;
+    std::vector<sf::VertexArray> curve, deriv;
 
-    std::vector<Token> parse(const std::string& s, std::string& err) {
-        std::vector<Token> toks;
-        err.clear();
-        
-        for (size_t i = 0; i < s.size();) {
-            char c = s[i];
-            
-            if (isspace(c)) { i++; continue; }
-            
-            if (isdigit(c) || c == '.') {
-                size_t j = i;
-                while (j < s.size() && (isdigit(s[j]) || s[j] == '.' || s[j] == 'e' || s[j] == 'E'))
-                    j++;
-                toks.push_back({Token::NUMBER, strtod(s.c_str() + i, 0)});
-                i = j;
-                continue;
-            }
-            
-            if (isalpha(c)) {
-                size_t j = i;
-                while (j < s.size() && isalnum(s[j])) j++;
-                std::string id = s.substr(i, j - i);
-                
-                if (id == "x") toks.push_back({Token::VAR_X});
-                else if (id == "pi") toks.push_back({Token::NUMBER, 3.14159265358979});
-                else if (id == "e") toks.push_back({Token::NUMBER, 2.71828182845905});
-                else toks.push_back({Token::FUNC, 0, id});
-                
-                i = j;
-                continue;
-            }
-            
-            if (c == '(') { toks.push_back({Token::LPAREN}); i++; continue; }
-            if (c == ')') { toks.push_back({Token::RPAREN}); i++; continue; }
-            
-            if (std::string("+-*/^").find(c) != std::string::npos) {
-                int p = (c == '+' || c == '-') ? 1 : (c == '*' || c == '/') ? 2 : 3;
-                toks.push_back({Token::OP, 0, std::string(1, c), p, c == '^'});
-                i++;
-                continue;
-            }
-            
-            err = "Karakter tidak dikenal: " + std::string(1, c);
-            return {};
-        }
-        
-        std::vector<Token> out;
-        for (size_t i = 0; i < toks.size(); i++) {
-            if (toks[i].type == Token::OP && toks[i].text == "-" &&
-                (i == 0 || toks[i-1].type == Token::OP || toks[i-1].type == Token::LPAREN))
-                out.push_back({Token::NUMBER, 0});
-            out.push_back(toks[i]);
-        }
-        return out;
-    }
-
-    std::vector<Token> toRPN(std::vector<Token> toks, std::string& err) {
-        std::vector<Token> out, st;
-        
-        for (auto& t : toks) {
-            if (t.type == Token::NUMBER || t.type == Token::VAR_X)
-                out.push_back(t);
-            else if (t.type == Token::FUNC)
-                st.push_back(t);
-            else if (t.type == Token::OP) {
-                while (!st.empty() && st.back().type == Token::OP &&
-                       ((!t.rightAssoc && t.precedence <= st.back().precedence) ||
-                        (t.rightAssoc && t.precedence < st.back().precedence))) {
-                    out.push_back(st.back());
-                    st.pop_back();
-                }
-                st.push_back(t);
-            } else if (t.type == Token::LPAREN)
-                st.push_back(t);
-            else if (t.type == Token::RPAREN) {
-                while (!st.empty() && st.back().type != Token::LPAREN) {
-                    out.push_back(st.back());
-                    st.pop_back();
-                }
-                if (st.empty()) { err = "Kurung tidak seimbang"; return {}; }
-                st.pop_back();
-                if (!st.empty() && st.back().type == Token::FUNC) {
-                    out.push_back(st.back());
-                    st.pop_back();
-                }
-            }
-        }
-        
-        while (!st.empty()) {
-            if (st.back().type == Token::LPAREN) {
-                err = "Kurung tidak seimbang";
-                return {};
-            }
-            out.push_back(st.back());
-            st.pop_back();
-        }
-        return out;
+    bool matches(const GraphView& v, bool d) const {
+        return valid && view == v && derivative == d;
     }
+};
 
-    double eval(std::vector<Token>& rpn, double x, bool& ok) {
-        ok = true;
-        std::vector<double> st;
-        
-        for (auto& t : rpn) {
-            if (t.type == Token::NUMBER)
-                st.push_back(t.value);
-            else if (t.type == Token::VAR_X)
-                st.push_back(x);
-            else if (t.type == Token::OP) {
-                if (st.size() < 2) { ok = false; return 0; }
-                double b = st.back(); st.pop_back();
-                double a = st.back(); st.pop_back();
-                double r = 0;
-                if (t.text == "+") r = a + b;
-                else if (t.text == "-") r = a - b;
-                else if (t.text == "*") r = a * b;
-                else if (t.text == "/") r = (b != 0) ? a / b : (ok = false, 0);
-                else if (t.text == "^") r = pow(a, b);
-                st.push_back(r);
-            } else if (t.type == Token::FUNC) {
-                if (st.empty()) { ok = false; return 0; }
-                double a = st.back(); st.pop_back();
-                auto it = funcs.find(t.text);
-                if (it != funcs.end())
-                    st.push_back(it->second(a));
-                else { ok = false; return 0; }
-            }
-        }
-        return st.size() == 1 ? st[0] : (ok = false, 0);
-    }
+// Geometry of all visible curves, finished for one view.
+struct CurveFrame {
+    GraphView view;
+    std::vector<sf::VertexArray> strips;
+};
 
-    // Numerical derivative
-    double derivative(std::vector<Token>& rpn, double x, bool& ok) {
-        const double h = 1e-6;
-        double y1 = eval(rpn, x + h, ok);
-        if (!ok) return 0;
-        double y2 = eval(rpn, x - h, ok);
-        if (!ok) return 0;
-        return (y1 - y2) / (2 * h);
-    }
+struct Function {
+    std::string expr;
+    Program prog;
+    JitProgram jit;     // native code for prog, or interpreter fallback
+    JitProgram deriv;   // symbolic f' if compact; empty means forward-mode dual
+    sf::Color color;
+    bool visible = true;
+    bool showDerivative = false;
+    bool implicit = false;  // prog is lhs - rhs of a relation in x and y
+    std::shared_ptr<CurveCache> cache = std::make_shared<CurveCache>();
 };
 
 // ============================================================================
@@ -253,24 +118,287 @@ int main() {
     bool showGrid = true;
     bool showAxesNumbers = true;
     bool showCrosshair = true;
+    
+    // Created once; curves are rebuilt one task per function, and their
+    // columns are evaluated in chunks of COLUMN_CHUNK on the same pool.
+    ThreadPool pool;
+    const size_t COLUMN_CHUNK = 256;
+    unsigned scene = 0;  // bumped whenever the function list changes
 
     auto compile = [&]() {
-        auto t = parser.parse(currentExpr, err);
+        // A relation "lhs = rhs" is plotted implicitly as lhs - rhs = 0.
+        std::string source = currentExpr;
+        size_t eq = currentExpr.find('=');
+        bool implicit = eq != std::string::npos;
+        if (implicit) {
+            std::string lhs = currentExpr.substr(0, eq), rhs = currentExpr.substr(eq + 1);
+            if (lhs.find_first_not_of(' ') == std::string::npos || rhs.find_first_not_of(' ') == std::string::npos ||
+                rhs.find('=') != std::string::npos) {
+                err = "Relasi harus berbentuk kiri = kanan";
+                return;
+            }
+            source = "(" + lhs + ")-(" + rhs + ")";
+        }
+        auto t = parser.parse(source, err);
         if (err.empty()) {
-            auto rpn = parser.toRPN(t, err);
-            if (err.empty() && !rpn.empty()) {
+            auto prog = parser.toRPN(t, err);
+            if (err.empty() && prog.usesY && !implicit) err = "Variabel y hanya untuk relasi (mis. x^2 + y^2 = 4) atau grafik 3D";
+            if (err.empty() && !prog.empty()) {
                 Function f;
                 f.expr = currentExpr;
-                f.rpn = rpn;
+                f.prog = prog;
+                f.implicit = implicit;
+                f.jit.compile(prog);
+                Program d;
+                std::string derr;
+                // Symbolic f' only pays off while it stays small; past 4x the
+                // size of f a dual-number pass over f is cheaper.
+                if (!implicit && parser.differentiate(prog, d, derr) && d.code.size() <= 4 * prog.code.size())
+                    f.deriv.compile(d);
                 static int colorIdx = 0;
                 sf::Color colors[] = {{50,90,200}, {200,50,90}, {50,200,90}, {200,150,50}, {150,50,200}};
                 f.color = colors[colorIdx++ % 5];
                 functions.push_back(f);
+                scene++;
                 currentExpr.clear();
             }
         }
     };
 
+    // Turns one column ring into line strips. Neighbouring columns are
+    // joined directly unless the curve bends by more than the flatness
+    // tolerance there, crosses a domain edge, or the interval bound cannot
+    // rule out a pole between them; those intervals are refined with the
+    // scalar evaluator f(x, y). Strips break at gaps, poles and wherever
+    // the curve leaves the graph area, and where the optional domain ring
+    // is undefined.
+    auto buildStrips = [&](const GraphView& view, const ColumnSamples& ring, const ColumnSamples* domain,
+                           auto f, const auto& bound, sf::Color color, std::vector<sf::VertexArray>& strips) {
+        CurveTolerance tol{view.scale, view.scale};
+        tol.yMin = (view.origin.y - GRAPH_BOTTOM) / view.scale;
+        tol.yMax = (view.origin.y - GRAPH_TOP) / view.scale;
+        int columns = ring.width();
+        auto column = [&](int px) {
+            CurvePoint p{ring.x(px), ring.y(px), ring.ok(px)};
+            p.ok = p.ok && std::isfinite(p.y) && (!domain || domain->ok(px));
+            return p;
+        };
+        auto bend = [&](int px) {
+            if (px <= 0 || px >= columns - 1) return 0.0;
+            CurvePoint l = column(px - 1), m = column(px), r = column(px + 1);
+            if (!l.ok || !m.ok || !r.ok) return 0.0;
+            return std::fabs(m.y - 0.5 * (l.y + r.y)) * view.scale;
+        };
+        
+        // Pole test per pixel pair, skipped for whole blocks the bound
+        // proves defined and continuous.
+        const int BLOCK = 16;
+        bool blockSmooth = false;
+        auto smooth = [&](int px0, int px1) {
+            Interval slope;
+            Interval v = bound(ring.x(px0), ring.x(px1), slope);
+            return v.defined && v.continuous;
+        };
+        
+        std::vector<CurvePoint> points;
+        points.push_back(column(0));
+        for (int px = 1; px < columns; px++) {
+            if (bound.known() && (px - 1) % BLOCK == 0)
+                blockSmooth = smooth(px - 1, std::min(px - 1 + BLOCK, columns - 1));
+            CurvePoint a = column(px - 1), b = column(px);
+            if (a.ok != b.ok || bend(px - 1) > tol.flatness || bend(px) > tol.flatness ||
+                (bound.known() && !blockSmooth && !smooth(px - 1, px)))
+                subdivideCurve(f, bound, tol, a, b, points);
+            else
+                appendCurvePoint(points, b);
+        }
+        
+        sf::VertexArray strip(sf::LineStrip);
+        auto flush = [&]() {
+            if (strip.getVertexCount() > 1) strips.push_back(strip);
+            strip.clear();
+        };
+        for (const CurvePoint& p : points) {
+            float screenY = view.origin.y - float(p.y) * view.scale;
+            if (p.ok && fabs(p.y) < 1e6 && screenY >= GRAPH_TOP && screenY <= GRAPH_BOTTOM)
+                strip.append({{float(view.origin.x + p.x * view.scale), screenY}, color});
+            else
+                flush();
+        }
+        flush();
+    };
+
+    // Traces an implicit relation over the graph area as one line list.
+    // Tracing stops early once the job is cancelled.
+    auto buildImplicit = [&](const Function& func, const GraphView& view, const std::atomic<bool>& cancelled) {
+        CurveCache& c = *func.cache;
+        auto f = [&](double x, double y, double& v) {
+            bool ok;
+            v = func.jit.eval(x, y, ok);
+            return ok;
+        };
+        auto bound = [&](Interval x, Interval y) { return parser.evalInterval(func.prog, x, y); };
+        std::vector<CurveSegment> segments = traceImplicit(f, bound,
+            -view.origin.x / view.scale, (view.origin.y - GRAPH_BOTTOM) / view.scale,
+            (GRAPH_RIGHT - view.origin.x) / view.scale, (view.origin.y - GRAPH_TOP) / view.scale, view.scale, &cancelled);
+        if (cancelled) return;
+        
+        sf::VertexArray lines(sf::Lines);
+        for (const CurveSegment& s : segments) {
+            lines.append({{float(view.origin.x + s.x0 * view.scale), float(view.origin.y - s.y0 * view.scale)}, func.color});
+            lines.append({{float(view.origin.x + s.x1 * view.scale), float(view.origin.y - s.y1 * view.scale)}, func.color});
+        }
+        if (lines.getVertexCount() > 0) c.curve.push_back(lines);
+    };
+
+    // Column rings and strips of an explicit y = f(x).
+    auto buildExplicit = [&](const Function& func, const GraphView& view, const std::atomic<bool>& cancelled) {
+        CurveCache& c = *func.cache;
+        const int columns = int(GRAPH_RIGHT);
+        c.f.update(view.origin.x, view.scale, columns, [&](const double* xs, double* ys, uint8_t* ok, size_t n) {
+            pool.parallelFor(n, COLUMN_CHUNK, [&](size_t b, size_t e) {
+                if (!cancelled) func.jit.evalBatch(xs + b, ys + b, ok + b, e - b);
+            });
+        });
+        if (cancelled) return;
+        buildStrips(view, c.f, nullptr, [&](double x, double& y) {
+            bool ok;
+            y = func.jit.eval(x, 0, ok);
+            return ok;
+        }, ProgramCurveBound{parser, func.prog}, func.color, c.curve);
+        
+        // Derivative if enabled
+        if (func.showDerivative) {
+            bool dual = func.deriv.program().empty();
+            c.df.update(view.origin.x, view.scale, columns, [&](const double* xs, double* dys, uint8_t* ok, size_t n) {
+                pool.parallelFor(n, COLUMN_CHUNK, [&](size_t b, size_t e) {
+                    if (cancelled) {
+                        return;
+                    } else if (!dual) {
+                        func.deriv.evalBatch(xs + b, dys + b, ok + b, e - b);
+                    } else {
+                        static thread_local std::vector<double> values;
+                        values.resize(e - b);
+                        parser.evalDualBatch(func.prog, xs + b, values.data(), dys + b, ok + b, e - b);
+                    }
+                });
+            });
+            if (cancelled) return;
+            sf::Color derivColor = func.color;
+            derivColor.a = 120;
+            // f' is only drawn where f itself is defined
+            auto evalDeriv = [&](double x, double& dy) {
+                bool ok, fok = true;
+                if (dual) {
+                    dy = parser.evalDual(func.prog, x, ok).d;
+                } else {
+                    dy = func.deriv.eval(x, 0, ok);
+                    func.jit.eval(x, 0, fok);
+                }
+                return ok && fok;
+            };
+            if (dual)
+                buildStrips(view, c.df, &c.f, evalDeriv, NoCurveBound(), derivColor, c.deriv);
+            else
+                buildStrips(view, c.df, &c.f, evalDeriv, ProgramCurveBound{parser, func.deriv.program()},
+                            derivColor, c.deriv);
+        }
+    };
+
+    // Brings func's column rings up to date with the view and rebuilds its
+    // strips. Column chunks are skipped once the job is cancelled; the rings
+    // are then invalidated since they hold a partial update.
+    auto buildCurves = [&](const Function& func, const GraphView& view, const std::atomic<bool>& cancelled) {
+        CurveCache& c = *func.cache;
+        c.valid = false;
+        c.curve.clear();
+        c.deriv.clear();
+        if (func.implicit) {
+            buildImplicit(func, view, cancelled);
+        } else {
+            buildExplicit(func, view, cancelled);
+        }
+        if (cancelled) {
+            c.f.invalidate();
+            c.df.invalidate();
+            return;
+        }
+        c.valid = true;
+        c.view = view;
+        c.derivative = func.showDerivative;
+    };
+
+    // Background curve building. The job slot is declared after
+    // everything the jobs use, frames included, so it is destroyed first:
+    // its destructor cancels and joins a running job before any of that
+    // state goes away.
+    LatestResult<CurveFrame> frames;
+    CurveFrame shown;
+    LatestJob jobs(pool);
+    GraphView posted;
+    unsigned postedScene = ~0u;
+    std::string notice;  // last export, shown in the status bar
+
+    // Writes the graph area as it is on screen (grid, axes, numbers and the
+    // shown curves) to an SVG or PDF file. Strips become polylines and the
+    // segments of implicit curves are joined first, so the simplifier sees
+    // whole curves.
+    auto exportVector = [&](const std::string& path) {
+        VectorDocument doc{int(GRAPH_RIGHT), int(GRAPH_HEIGHT)};
+        auto at = [&](float x, float y) { return PathPoint{x, y - GRAPH_TOP}; };
+        if (showGrid) {
+            for (int i = -50; i < 50; i++) {
+                float x = origin.x + i * scale * 0.5f, y = origin.y + i * scale * 0.5f;
+                if (x >= 0 && x <= GRAPH_RIGHT) doc.polyline({at(x, GRAPH_TOP), at(x, GRAPH_BOTTOM)}, {230, 230, 230});
+                if (y >= GRAPH_TOP && y <= GRAPH_BOTTOM) doc.polyline({at(0, y), at(GRAPH_RIGHT, y)}, {230, 230, 230});
+            }
+        }
+        if (origin.x >= 0 && origin.x <= GRAPH_RIGHT)
+            doc.polyline({at(origin.x, GRAPH_TOP), at(origin.x, GRAPH_BOTTOM)}, {180, 80, 80});
+        if (origin.y >= GRAPH_TOP && origin.y <= GRAPH_BOTTOM)
+            doc.polyline({at(0, origin.y), at(GRAPH_RIGHT, origin.y)}, {180, 80, 80});
+        if (showAxesNumbers && origin.x >= 0 && origin.x <= GRAPH_RIGHT && origin.y >= GRAPH_TOP && origin.y <= GRAPH_BOTTOM) {
+            for (int i = -30; i <= 30; i++) {
+                if (i == 0) continue;
+                float x = origin.x + i * scale, y = origin.y - i * scale;
+                if (x >= 0 && x <= GRAPH_RIGHT) {
+                    PathPoint p = at(x - 8, origin.y + 5);
+                    doc.text(p.x, p.y, std::to_string(i), 11, {100, 100, 100});
+                }
+                if (y >= GRAPH_TOP && y <= GRAPH_BOTTOM) {
+                    PathPoint p = at(origin.x + 5, y - 8);
+                    doc.text(p.x, p.y, std::to_string(i), 11, {100, 100, 100});
+                }
+            }
+        }
+        if (shown.view.scale > 0) {
+            float k = scale / shown.view.scale;
+            sf::Transform reproject;
+            reproject.translate(origin).scale(k, k).translate(-shown.view.origin);
+            for (const sf::VertexArray& strip : shown.strips) {
+                if (strip.getVertexCount() < 2) continue;
+                sf::Color c = strip[0].color;
+                std::vector<PathPoint> pts;
+                for (size_t i = 0; i < strip.getVertexCount(); i++) {
+                    sf::Vector2f p = reproject.transformPoint(strip[i].position);
+                    pts.push_back(at(p.x, p.y));
+                }
+                if (strip.getPrimitiveType() == sf::Lines) {
+                    for (const std::vector<PathPoint>& path : joinSegments(pts))
+                        doc.polyline(path, {c.r, c.g, c.b}, c.a / 255.0f);
+                } else {
+                    doc.polyline(pts, {c.r, c.g, c.b}, c.a / 255.0f);
+                }
+            }
+        }
+        if (doc.write(path)) {
+            err.clear();
+            notice = "Disimpan: " + path;
+        } else {
+            err = "Gagal menulis " + path;
+        }
+    };
+
     while (win.isOpen()) {
         sf::Event e;
         while (win.pollEvent(e)) {
@@ -292,8 +420,18 @@ int main() {
                 if (e.key.code == sf::Keyboard::G) showGrid = !showGrid;
                 if (e.key.code == sf::Keyboard::N) showAxesNumbers = !showAxesNumbers;
                 if (e.key.code == sf::Keyboard::C) showCrosshair = !showCrosshair;
+                if (e.key.code == sf::Keyboard::S && e.key.control) exportVector(e.key.shift ? "grafik.pdf" : "grafik.svg");
+                // Ctrl+D: plain D is typed into the expression. The cache of
+                // the function no longer matches once the flag flips, so the
+                // next job rebuilds it with or without f'.
+                if (e.key.code == sf::Keyboard::D && e.key.control && selectedFunc >= 0 &&
+                    selectedFunc < int(functions.size()) && !functions[selectedFunc].implicit) {
+                    functions[selectedFunc].showDerivative = !functions[selectedFunc].showDerivative;
+                    scene++;
+                }
                 if (e.key.code == sf::Keyboard::Delete && selectedFunc >= 0 && selectedFunc < functions.size()) {
                     functions.erase(functions.begin() + selectedFunc);
+                    scene++;
                     selectedFunc = -1;
                 }
             }
@@ -397,64 +535,39 @@ int main() {
             }
         }
         
-        // Draw functions
-        for (auto& func : functions) {
-            if (!func.visible) continue;
-            
-            // Draw main function
-            sf::VertexArray curve(sf::LineStrip);
-            double prevY = 0;
-            bool havePrev = false;
-            
-            for (int px = 0; px < GRAPH_RIGHT; px++) {
-                bool ok;
-                double x = (px - origin.x) / scale;
-                double y = parser.eval(func.rpn, x, ok);
-                
-                if (ok && !std::isnan(y) && !std::isinf(y) && fabs(y) < 1e6) {
-                    float screenY = origin.y - float(y) * scale;
-                    
-                    if (screenY >= GRAPH_TOP && screenY <= GRAPH_BOTTOM) {
-                        if (havePrev && fabs(y - prevY) * scale > 3000) {
-                            win.draw(curve);
-                            curve.clear();
-                        }
-                        
-                        curve.append({{float(px), screenY}, func.color});
-                        prevY = y;
-                        havePrev = true;
-                    } else {
-                        if (curve.getVertexCount() > 1) win.draw(curve);
-                        curve.clear();
-                        havePrev = false;
-                    }
-                } else {
-                    if (curve.getVertexCount() > 1) win.draw(curve);
-                    curve.clear();
-                    havePrev = false;
+        // Draw functions. Geometry is rebuilt off the UI thread whenever the
+        // view or the function list changes; until it arrives the last
+        // finished frame is mapped onto the current view, so pans and zooms
+        // stay smooth at the cost of briefly stretched curves.
+        const GraphView view{origin, scale, win.getSize()};
+        if (view != posted || scene != postedScene) {
+            posted = view;
+            postedScene = scene;
+            std::vector<Function> visible;
+            for (auto& func : functions)
+                if (func.visible) visible.push_back(func);
+            jobs.post([&, view, visible](const std::atomic<bool>& cancelled) {
+                pool.parallelFor(visible.size(), 1, [&](size_t begin, size_t end) {
+                    for (size_t k = begin; k < end && !cancelled; k++)
+                        if (!visible[k].cache->matches(view, visible[k].showDerivative))
+                            buildCurves(visible[k], view, cancelled);
+                });
+                if (cancelled) return;
+                CurveFrame frame;
+                frame.view = view;
+                for (auto& func : visible) {
+                    frame.strips.insert(frame.strips.end(), func.cache->curve.begin(), func.cache->curve.end());
+                    frame.strips.insert(frame.strips.end(), func.cache->deriv.begin(), func.cache->deriv.end());
                 }
-            }
-            if (curve.getVertexCount() > 1) win.draw(curve);
-            
-            // Draw derivative if enabled
-            if (func.showDerivative) {
-                sf::VertexArray deriv(sf::LineStrip);
-                for (int px = 0; px < GRAPH_RIGHT; px++) {
-                    bool ok;
-                    double x = (px - origin.x) / scale;
-                    double dy = parser.derivative(func.rpn, x, ok);
-                    
-                    if (ok && !std::isnan(dy) && !std::isinf(dy) && fabs(dy) < 1e6) {
-                        float screenY = origin.y - float(dy) * scale;
-                        if (screenY >= GRAPH_TOP && screenY <= GRAPH_BOTTOM) {
-                            sf::Color derivColor = func.color;
-                            derivColor.a = 120;
-                            deriv.append({{float(px), screenY}, derivColor});
-                        }
-                    }
-                }
-                if (deriv.getVertexCount() > 1) win.draw(deriv);
-            }
+                frames.put(std::move(frame));
+            });
+        }
+        frames.take(shown);
+        if (shown.view.scale > 0) {
+            float k = scale / shown.view.scale;
+            sf::Transform reproject;
+            reproject.translate(origin).scale(k, k).translate(-shown.view.origin);
+            for (auto& strip : shown.strips) win.draw(strip, reproject);
         }
         
         // Draw crosshair
@@ -492,7 +605,7 @@ int main() {
         txt.setFont(font);
         txt.setCharacterSize(16);
         txt.setFillColor(sf::Color::Black);
-        txt.setString("Fungsi f(x): " + currentExpr);
+        txt.setString("Fungsi f(x) / relasi: " + currentExpr);
         txt.setPosition(10, 10);
         win.draw(txt);
         
@@ -500,7 +613,7 @@ int main() {
         helpTxt.setFont(font);
         helpTxt.setCharacterSize(12);
         helpTxt.setFillColor({80, 80, 80});
-        helpTxt.setString("Enter: add | R: reset | G: grid | N: numbers | C: crosshair | Del: hapus fungsi");
+        helpTxt.setString("Enter: add | R: reset | G: grid | N: numbers | C: crosshair | Del: hapus fungsi | Ctrl+D: turunan | Ctrl+S: SVG, Ctrl+Shift+S: PDF");
         helpTxt.setPosition(10, 38);
         win.draw(helpTxt);
         
@@ -552,6 +665,7 @@ int main() {
             funcText.setFillColor(sf::Color::Black);
             std::string label = functions[i].expr;
             if (label.length() > 25) label = label.substr(0, 22) + "...";
+            if (functions[i].showDerivative) label += "  + f'";
             funcText.setString(label);
             funcText.setPosition(GRAPH_RIGHT + 30, y + 4);
             win.draw(funcText);
@@ -582,7 +696,7 @@ int main() {
             statusTxt.setCharacterSize(12);
             statusTxt.setFillColor({80, 80, 80});
             statusTxt.setString("Scale: " + std::to_string(int(scale)) + "px/unit | Functions: " + 
-                              std::to_string(functions.size()));
+                              std::to_string(functions.size()) + (notice.empty() ? "" : " | " + notice));
             statusTxt.setPosition(10, GRAPH_BOTTOM + 8);
             win.draw(statusTxt);
         }
@@ -1,12 +1,17 @@
 #include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
 #include <cmath>
 #include <string>
 #include <vector>
-#include <map>
-#include <functional>
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <memory>
+
+#include "camera.hpp"
+#include "jit.hpp"
+#include "pool.hpp"
+#include "surface.hpp"
 
 // ============================================================================
 // KONSTANTA KONFIGURASI
@@ -19,35 +24,152 @@ const float BUTTON_HEIGHT = 40.f;
 const float TOP_BAR_HEIGHT = 130.f;
 const float RIGHT_PANEL_WIDTH = 280.f;
 
-const int GRID_SIZE = 50; // Increased for better quality
-const float GRID_RANGE = 3.5f;
+// Adaptive tessellation (surface.hpp): a cell is split while its midpoints
+// stray more than LOD_TOLERANCE_PX pixels (at the current zoom) from the
+// bilinear patch through its corners; while rotating on the CPU path the
+// tolerance is multiplied by LOD_DRAG_FACTOR.
+const float LOD_TOLERANCE_PX = 1.f;
+const float LOD_DRAG_FACTOR = 4.f;
+
+// Contour mode draws level lines every contourStep in z, projected onto
+// the floor plane z = CONTOUR_FLOOR.
+const float CONTOUR_FLOOR = -GRID_RANGE;
+const float CONTOUR_STEP_DEFAULT = 0.5f;
+
+// Arah cahaya (ternormalisasi) untuk shading Lambert
+const float LIGHT_X = 0.3f, LIGHT_Y = 0.4f, LIGHT_Z = 0.866f;
+
+// Vertex shader for surfaces kept in a vertex buffer: the vertex holds the
+// world point as (position.x, position.y, texCoords.x) and the camera
+// matrix (camera.hpp) arrives as a uniform. The view depth goes to the
+// depth buffer (|depth| stays below 16 for z within +-10), and depthBias
+// pulls wireframes in front of the filled surface they lie on. Plain
+// GLSL 1.10, so it also runs on software GL such as Mesa llvmpipe.
+const char* SURFACE_VERTEX_SHADER = R"(
+uniform mat4 camera;
+uniform float depthBias;
+void main() {
+    vec4 p = camera * vec4(gl_Vertex.xy, gl_MultiTexCoord0.x, 1.0);
+    gl_Position = gl_ProjectionMatrix * gl_ModelViewMatrix * vec4(p.xy / p.w, 0.0, 1.0);
+    gl_Position.z = p.z / 32.0 + depthBias;
+    gl_FrontColor = gl_Color;
+}
+)";
 
 // ============================================================================
 // STRUKTUR DATA
 // ============================================================================
 
-struct Token {
-    enum Type { NUMBER, VAR_X, VAR_Y, OP, FUNC, LPAREN, RPAREN } type;
-    double value{};
-    std::string text;
-    int precedence{};
-    bool rightAssoc{};
-};
-
 struct Point3D {
     float x, y, z;
     Point3D(float x = 0, float y = 0, float z = 0) : x(x), y(y), z(z) {}
 };
 
+// A surface's samples plus the colours the grapher draws it with: the
+// height tint and, if litShading, the Lambert term per lattice point,
+// computed once per point and shading mode. Only the background job
+// touches it.
+struct ShadedMesh : SurfaceMesh {
+    std::vector<sf::Color> colors;
+    std::vector<uint8_t> lit;
+    bool litShading = false;
+};
+
 struct Function3D {
     std::string expr;
-    std::vector<Token> rpn;
+    Program prog;
+    JitProgram jit;     // native code for prog, or interpreter fallback
     sf::Color color;
     bool visible = true;
     bool showWireframe = true;
     bool showSurface = false;
+    std::shared_ptr<ShadedMesh> mesh = std::make_shared<ShadedMesh>();
+};
+
+// Camera state and tessellation tolerance a frame of surface geometry was
+// built for.
+struct SurfaceView {
+    sf::Vector2f origin;
+    float scale = 0;
+    float rotX = 0, rotY = 0;
+    bool shading = false;
+    float tolerance = 0;
+    float contourStep = 0;  // 0 = no contours
+
+    bool operator==(const SurfaceView& v) const {
+        return origin == v.origin && scale == v.scale && rotX == v.rotX && rotY == v.rotY &&
+               shading == v.shading && tolerance == v.tolerance && contourStep == v.contourStep;
+    }
+    bool operator!=(const SurfaceView& v) const { return !(*this == v); }
 };
 
+// Geometry of one chunk of leaves. In world form the vertices are world
+// points as sf::Lines (contours) and sf::Triangles (filled surface), and
+// the wireframe is kept per surface in SurfaceWire. Otherwise they are
+// projected, vertices also holding the wireframe as sf::Lines, with each
+// fill triangle's view depth in fillDepth.
+struct SurfaceChunk {
+    std::vector<sf::Vertex> vertices;
+    std::vector<sf::Vertex> fill;
+    std::vector<float> fillDepth;
+};
+
+// World-form wireframe of one surface: line strips of the given lengths,
+// each lattice point stored about once per direction.
+struct SurfaceWire {
+    std::vector<sf::Vertex> vertices;
+    std::vector<size_t> runs;
+};
+
+// Geometry of all visible surfaces for one view. In projected form the
+// triangles of every chunk are merged into fill, sorted back to front.
+struct SurfaceFrame {
+    SurfaceView view;
+    bool world = false;
+    std::vector<SurfaceChunk> chunks;
+    std::vector<SurfaceWire> wires;
+    std::vector<sf::Vertex> fill;
+    size_t samples = 0, leaves = 0;
+};
+
+// Uploads one kind of world-form geometry (e.g. &SurfaceChunk::vertices)
+// into a static vertex buffer and returns its vertex count.
+size_t uploadVertices(const SurfaceFrame& frame, std::vector<sf::Vertex> SurfaceChunk::*vertices,
+                      sf::VertexBuffer& buffer) {
+    size_t total = 0;
+    for (auto& chunk : frame.chunks) total += (chunk.*vertices).size();
+    if (total == 0 || !buffer.create(total)) return 0;
+    size_t offset = 0;
+    for (auto& chunk : frame.chunks) {
+        const std::vector<sf::Vertex>& v = chunk.*vertices;
+        if (v.empty()) continue;
+        buffer.update(v.data(), v.size(), unsigned(offset));
+        offset += v.size();
+    }
+    return total;
+}
+
+// Uploads the wireframe strips of a world-form frame into one static
+// vertex buffer; runs receives the (first, count) range of every strip.
+void uploadStrips(const SurfaceFrame& frame, sf::VertexBuffer& buffer,
+                  std::vector<std::pair<size_t, size_t>>& runs) {
+    size_t total = 0;
+    for (auto& wire : frame.wires) total += wire.vertices.size();
+    runs.clear();
+    if (total == 0 || !buffer.create(total)) return;
+    size_t offset = 0;
+    for (auto& wire : frame.wires) {
+        if (wire.vertices.empty()) continue;
+        buffer.update(wire.vertices.data(), wire.vertices.size(), unsigned(offset));
+        size_t first = offset;
+        for (size_t len : wire.runs) {
+            runs.push_back({first, len});
+            first += len;
+        }
+        offset += wire.vertices.size();
+    }
+}
+
 struct InputBox {
     sf::RectangleShape box;
     sf::Text text;
@@ -87,184 +209,56 @@ struct Button {
 };
 
 // ============================================================================
-// PARSER - Parsing dan Evaluasi Ekspresi dengan 2 Variabel
+// 3D PROJECTION
 // ============================================================================
 
-class Parser {
-    std::map<std::string, std::function<double(double)>> funcs;
-    
-public:
-    Parser() {
-        funcs = {
-            {"sin", [](double x) { return sin(x); }},
-            {"cos", [](double x) { return cos(x); }},
-            {"tan", [](double x) { return tan(x); }},
-            {"asin", [](double x) { return asin(x); }},
-            {"acos", [](double x) { return acos(x); }},
-            {"atan", [](double x) { return atan(x); }},
-            {"sinh", [](double x) { return sinh(x); }},
-            {"cosh", [](double x) { return cosh(x); }},
-            {"tanh", [](double x) { return tanh(x); }},
-            {"exp", [](double x) { return exp(x); }},
-            {"ln", [](double x) { return log(x); }},
-            {"log", [](double x) { return log10(x); }},
-            {"sqrt", [](double x) { return sqrt(x); }},
-            {"abs", [](double x) { return fabs(x); }},
-            {"floor", [](double x) { return floor(x); }},
-            {"ceil", [](double x) { return ceil(x); }}
-        };
-    }
+sf::Vector2f project3D(const Camera& cam, Point3D p) {
+    sf::Vector2f s;
+    cam.project(p.x, p.y, p.z, s.x, s.y);
+    return s;
+}
 
-    std::vector<Token> parse(const std::string& s, std::string& err) {
-        std::vector<Token> toks;
-        err.clear();
-        
-        for (size_t i = 0; i < s.size();) {
-            char c = s[i];
-            
-            if (isspace(c)) { i++; continue; }
-            
-            if (isdigit(c) || c == '.') {
-                size_t j = i;
-                while (j < s.size() && (isdigit(s[j]) || s[j] == '.' || s[j] == 'e' || s[j] == 'E' || s[j] == '-'))
-                    j++;
-                toks.push_back({Token::NUMBER, strtod(s.c_str() + i, 0)});
-                i = j;
-                continue;
-            }
-            
-            if (isalpha(c)) {
-                size_t j = i;
-                while (j < s.size() && isalnum(s[j])) j++;
-                std::string id = s.substr(i, j - i);
-                
-                if (id == "x") toks.push_back({Token::VAR_X});
-                else if (id == "y") toks.push_back({Token::VAR_Y});
-                else if (id == "pi") toks.push_back({Token::NUMBER, 3.14159265358979});
-                else if (id == "e") toks.push_back({Token::NUMBER, 2.71828182845905});
-                else toks.push_back({Token::FUNC, 0, id});
-                
-                i = j;
-                continue;
-            }
-            
-            if (c == '(') { toks.push_back({Token::LPAREN}); i++; continue; }
-            if (c == ')') { toks.push_back({Token::RPAREN}); i++; continue; }
-            
-            if (std::string("+-*/^").find(c) != std::string::npos) {
-                int p = (c == '+' || c == '-') ? 1 : (c == '*' || c == '/') ? 2 : 3;
-                toks.push_back({Token::OP, 0, std::string(1, c), p, c == '^'});
-                i++;
-                continue;
-            }
-            
-            err = "Karakter tidak dikenal: '" + std::string(1, c) + "'";
-            return {};
-        }
-        
-        std::vector<Token> out;
-        for (size_t i = 0; i < toks.size(); i++) {
-            if (toks[i].type == Token::OP && toks[i].text == "-" &&
-                (i == 0 || toks[i-1].type == Token::OP || toks[i-1].type == Token::LPAREN))
-                out.push_back({Token::NUMBER, 0});
-            out.push_back(toks[i]);
-        }
-        return out;
-    }
 
-    std::vector<Token> toRPN(std::vector<Token> toks, std::string& err) {
-        std::vector<Token> out, st;
-        
-        for (auto& t : toks) {
-            if (t.type == Token::NUMBER || t.type == Token::VAR_X || t.type == Token::VAR_Y)
-                out.push_back(t);
-            else if (t.type == Token::FUNC)
-                st.push_back(t);
-            else if (t.type == Token::OP) {
-                while (!st.empty() && st.back().type == Token::OP &&
-                       ((!t.rightAssoc && t.precedence <= st.back().precedence) ||
-                        (t.rightAssoc && t.precedence < st.back().precedence))) {
-                    out.push_back(st.back());
-                    st.pop_back();
-                }
-                st.push_back(t);
-            } else if (t.type == Token::LPAREN)
-                st.push_back(t);
-            else if (t.type == Token::RPAREN) {
-                while (!st.empty() && st.back().type != Token::LPAREN) {
-                    out.push_back(st.back());
-                    st.pop_back();
-                }
-                if (st.empty()) { err = "Kurung tidak seimbang"; return {}; }
-                st.pop_back();
-                if (!st.empty() && st.back().type == Token::FUNC) {
-                    out.push_back(st.back());
-                    st.pop_back();
-                }
-            }
-        }
-        
-        while (!st.empty()) {
-            if (st.back().type == Token::LPAREN) {
-                err = "Kurung tidak seimbang";
-                return {};
-            }
-            out.push_back(st.back());
-            st.pop_back();
-        }
-        return out;
-    }
+// Wireframe colour of lattice point k; darker over a filled surface.
+inline sf::Color wireColor(const ShadedMesh& m, int k, bool overSurface) {
+    sf::Color c = m.colors[k];
+    if (overSurface) c = sf::Color(c.r * 3 / 5, c.g * 3 / 5, c.b * 3 / 5);
+    return c;
+}
 
-    double eval(std::vector<Token>& rpn, double x, double y, bool& ok) {
-        ok = true;
-        std::vector<double> st;
-        
-        for (auto& t : rpn) {
-            if (t.type == Token::NUMBER)
-                st.push_back(t.value);
-            else if (t.type == Token::VAR_X)
-                st.push_back(x);
-            else if (t.type == Token::VAR_Y)
-                st.push_back(y);
-            else if (t.type == Token::OP) {
-                if (st.size() < 2) { ok = false; return 0; }
-                double b = st.back(); st.pop_back();
-                double a = st.back(); st.pop_back();
-                double r = 0;
-                if (t.text == "+") r = a + b;
-                else if (t.text == "-") r = a - b;
-                else if (t.text == "*") r = a * b;
-                else if (t.text == "/") r = (b != 0) ? a / b : (ok = false, 0);
-                else if (t.text == "^") r = pow(a, b);
-                st.push_back(r);
-            } else if (t.type == Token::FUNC) {
-                if (st.empty()) { ok = false; return 0; }
-                double a = st.back(); st.pop_back();
-                if (funcs.find(t.text) == funcs.end()) { ok = false; return 0; }
-                st.push_back(funcs[t.text](a));
-            }
-        }
-        return st.size() == 1 ? st[0] : (ok = false, 0);
-    }
-};
 
 // ============================================================================
-// 3D PROJECTION
+// KONTUR - garis level dengan marching triangles
 // ============================================================================
 
-sf::Vector2f project3D(Point3D p, float rotX, float rotY, float scale, sf::Vector2f origin) {
-    float cosY = cos(rotY), sinY = sin(rotY);
-    float x1 = p.x * cosY - p.z * sinY;
-    float z1 = p.x * sinY + p.z * cosY;
-    
-    float cosX = cos(rotX), sinX = sin(rotX);
-    float y2 = p.y * cosX - z1 * sinX;
-    float z2 = p.y * sinX + z1 * cosX;
-    
-    float distance = 15.0f;
-    float factor = distance / (distance + z2);
-    
-    return {origin.x + x1 * factor * scale, origin.y - y2 * factor * scale};
+// Calls out(x0, y0, x1, y1) with the piece of every level line z = k * step
+// crossing the triangle (a, b, d) of lattice points. A crossing is always
+// interpolated from the lower lattice index, so triangles sharing an edge
+// agree on it exactly and the lines join without cracks, also across the
+// T-junctions of the quadtree.
+template <typename Out>
+void contourTriangle(const SurfaceMesh& m, int a, int b, int d, double step, Out out) {
+    const int p[3] = {a, b, d};
+    double lo = std::min({m.z[a], m.z[b], m.z[d]}), hi = std::max({m.z[a], m.z[b], m.z[d]});
+    auto cross = [&](int u, int v, double level, double& x, double& y) {
+        if (u > v) std::swap(u, v);
+        double t = (level - m.z[u]) / (m.z[v] - m.z[u]);
+        x = latticeCoord(u / (GRID_MAX + 1)) + t * (latticeCoord(v / (GRID_MAX + 1)) - latticeCoord(u / (GRID_MAX + 1)));
+        y = latticeCoord(u % (GRID_MAX + 1)) + t * (latticeCoord(v % (GRID_MAX + 1)) - latticeCoord(u % (GRID_MAX + 1)));
+    };
+    for (double k = std::ceil(lo / step); k * step <= hi; k++) {
+        double level = k * step;
+        double x[2], y[2];
+        int n = 0;
+        for (int e = 0; e < 3 && n < 2; e++) {
+            int u = p[e], v = p[(e + 1) % 3];
+            if ((m.z[u] < level) != (m.z[v] < level)) {
+                cross(u, v, level, x[n], y[n]);
+                n++;
+            }
+        }
+        if (n == 2) out(level, x[0], y[0], x[1], y[1]);
+    }
 }
 
 std::string formatNumber(double val) {
@@ -283,6 +277,7 @@ std::string formatNumber(double val) {
 int main() {
     sf::ContextSettings settings;
     settings.antialiasingLevel = 4;
+    settings.depthBits = 24;
     
     sf::RenderWindow win(sf::VideoMode(1400, 900), "Grapher 3D - Kalkulus 2 (Revised)", sf::Style::Default, settings);
     win.setFramerateLimit(60);
@@ -311,8 +306,31 @@ int main() {
     
     bool showAxes = true;
     bool showGrid = true;
+    bool showShading = true;
+    bool showContours = false;
+    float contourStep = CONTOUR_STEP_DEFAULT;
     sf::Clock clock;
     
+    // Surfaces are sampled in batches and turned into geometry in chunks
+    // of LEAF_CHUNK quadtree leaves on the pool.
+    ThreadPool pool;
+    const size_t SAMPLE_CHUNK = 256;
+    const size_t LEAF_CHUNK = 512;
+    unsigned scene = 0;  // bumped whenever the function list changes
+
+    // With shaders the wireframe lives in a static vertex buffer and only
+    // the camera uniform changes per frame; otherwise it is projected on
+    // the CPU and re-sent every frame.
+    sf::Shader surfaceShader;
+    const bool gpu = sf::VertexBuffer::isAvailable() && sf::Shader::isAvailable() &&
+                     surfaceShader.loadFromMemory(SURFACE_VERTEX_SHADER, sf::Shader::Vertex);
+    sf::VertexBuffer surfaceBuffer(sf::Lines, sf::VertexBuffer::Static);
+    sf::VertexBuffer wireBuffer(sf::LineStrip, sf::VertexBuffer::Static);
+    sf::VertexBuffer fillBuffer(sf::Triangles, sf::VertexBuffer::Static);
+    size_t surfaceCount = 0, fillCount = 0;
+    std::vector<std::pair<size_t, size_t>> wireRuns;
+    size_t shownSamples = 0, shownLeaves = 0;
+    
     // Input Box
     InputBox inputBox;
     inputBox.content = "sin(x)*cos(y)";
@@ -352,11 +370,12 @@ int main() {
     auto compile = [&]() {
         auto t = parser.parse(inputBox.content, err);
         if (err.empty()) {
-            auto rpn = parser.toRPN(t, err);
-            if (err.empty() && !rpn.empty()) {
+            auto prog = parser.toRPN(t, err);
+            if (err.empty() && !prog.empty()) {
                 Function3D f;
                 f.expr = inputBox.content;
-                f.rpn = rpn;
+                f.prog = prog;
+                f.jit.compile(prog);
                 static int colorIdx = 0;
                 sf::Color colors[] = {
                     {70, 120, 220}, {220, 70, 120}, {70, 220, 120}, 
@@ -364,11 +383,22 @@ int main() {
                 };
                 f.color = colors[colorIdx++ % 6];
                 functions.push_back(f);
+                scene++;
                 inputBox.content.clear();
             }
         }
     };
 
+    // Background surface building. The job slot is declared after
+    // everything the jobs use, frames included, so it is destroyed first:
+    // its destructor cancels and joins a running job before any of that
+    // state goes away.
+    LatestResult<SurfaceFrame> frames;
+    SurfaceFrame shown;
+    LatestJob jobs(pool);
+    SurfaceView posted;
+    unsigned postedScene = ~0u;
+
     while (win.isOpen()) {
         sf::Event e;
         sf::Vector2f mousePos = sf::Vector2f(sf::Mouse::getPosition(win));
@@ -442,8 +472,23 @@ int main() {
                 }
                 if (e.key.code == sf::Keyboard::A) showAxes = !showAxes;
                 if (e.key.code == sf::Keyboard::G) showGrid = !showGrid;
+                if (e.key.code == sf::Keyboard::L) showShading = !showShading;
+                if (e.key.code == sf::Keyboard::C) showContours = !showContours;
+                if (e.key.code == sf::Keyboard::Comma) contourStep = std::max(contourStep / 2, 1.f / 64);
+                if (e.key.code == sf::Keyboard::Period) contourStep = std::min(contourStep * 2, 8.f);
+                // F / W toggle the filled surface / wireframe of the selected
+                // function, or of all of them when none is selected.
+                if (e.key.code == sf::Keyboard::F || e.key.code == sf::Keyboard::W) {
+                    for (size_t i = 0; i < functions.size(); i++) {
+                        if (selectedFunc >= 0 && int(i) != selectedFunc) continue;
+                        bool& flag = e.key.code == sf::Keyboard::F ? functions[i].showSurface : functions[i].showWireframe;
+                        flag = !flag;
+                    }
+                    scene++;
+                }
                 if (e.key.code == sf::Keyboard::Delete && selectedFunc >= 0 && selectedFunc < functions.size()) {
                     functions.erase(functions.begin() + selectedFunc);
+                    scene++;
                     selectedFunc = -1;
                 }
             }
@@ -523,7 +568,7 @@ int main() {
         helpText.setFont(font);
         helpText.setCharacterSize(12);
         helpText.setFillColor({110, 110, 110});
-        helpText.setString("Enter = Add  |  R = Reset  |  G = Grid  |  A = Axes  |  Delete = Remove  |  Drag = Rotate  |  Scroll = Zoom");
+        helpText.setString("Enter = Add  |  R = Reset  |  G = Grid  |  A = Axes  |  L = Shading  |  F = Fill  |  W = Wire  |  C = Contour (, .)  |  Delete = Remove  |  Drag = Rotate  |  Scroll = Zoom");
         helpText.setPosition(20, 85);
         win.draw(helpText);
         
@@ -535,82 +580,363 @@ int main() {
         constText.setPosition(20, 105);
         win.draw(constText);
         
-        // Draw 3D surfaces
-        for (auto& func : functions) {
-            if (!func.visible) continue;
-            
-            const float step = (2 * GRID_RANGE) / GRID_SIZE;
-            std::vector<sf::Vertex> lines;
-            
-            for (int i = 0; i <= GRID_SIZE; i++) {
-                for (int j = 0; j <= GRID_SIZE; j++) {
-                    float x = -GRID_RANGE + i * step;
-                    float y = -GRID_RANGE + j * step;
-                    
-                    bool ok;
-                    float z = parser.eval(func.rpn, x, y, ok);
-                    
-                    if (!ok || std::isnan(z) || std::isinf(z) || fabs(z) > 10) continue;
-                    
-                    auto p = project3D({x, y, z}, rotX, rotY, scale, origin);
-                    
-                    float h = std::min(std::max((z + 2) / 4.0f, 0.f), 1.f);
-                    sf::Color baseColor = func.color;
-                    sf::Color color(
-                        static_cast<sf::Uint8>(baseColor.r * (0.4f + h * 0.6f)),
-                        static_cast<sf::Uint8>(baseColor.g * (0.4f + h * 0.6f)),
-                        static_cast<sf::Uint8>(baseColor.b * (0.4f + h * 0.6f))
-                    );
-                    
-                    if (i < GRID_SIZE) {
-                        float x2 = -GRID_RANGE + (i + 1) * step;
-                        bool ok2;
-                        float z2 = parser.eval(func.rpn, x2, y, ok2);
-                        if (ok2 && !std::isnan(z2) && !std::isinf(z2) && fabs(z2) < 10) {
-                            auto p2 = project3D({x2, y, z2}, rotX, rotY, scale, origin);
-                            float h2 = std::min(std::max((z2 + 2) / 4.0f, 0.f), 1.f);
-                            sf::Color color2(
-                                static_cast<sf::Uint8>(baseColor.r * (0.4f + h2 * 0.6f)),
-                                static_cast<sf::Uint8>(baseColor.g * (0.4f + h2 * 0.6f)),
-                                static_cast<sf::Uint8>(baseColor.b * (0.4f + h2 * 0.6f))
+        // Draw 3D surfaces. Tessellation, lighting and vertex building run
+        // in a background job on the pool. Until a new frame arrives the
+        // last one is drawn: zoom only scales about the origin, so it is
+        // mapped onto the current view; after a rotation it is shown as it
+        // was until the reprojected one replaces it. The tolerance follows
+        // the zoom in powers of two, so small zoom steps reuse the mesh.
+        float tolerance = LOD_TOLERANCE_PX / std::exp2(std::round(std::log2(scale)));
+        // On the GPU path the geometry does not depend on the camera, and
+        // rotating costs nothing, so only the CPU path drops detail while
+        // dragging.
+        const float contours = showContours ? contourStep : 0;
+        const SurfaceView view = gpu ? SurfaceView{{}, 0, 0, 0, showShading, tolerance, contours}
+                                     : SurfaceView{origin, scale, rotX, rotY, showShading,
+                                                   dragging ? tolerance * LOD_DRAG_FACTOR : tolerance, contours};
+        if (view != posted || scene != postedScene) {
+            posted = view;
+            postedScene = scene;
+            std::vector<Function3D> visible;
+            for (auto& func : functions)
+                if (func.visible) visible.push_back(func);
+            jobs.post([&, view, visible](const std::atomic<bool>& cancelled) mutable {
+                // Evaluates z and the exact gradient at lattice points.
+                auto sampler = [&](const Function3D& func) {
+                    return [&, f = &func](const std::vector<int>& points) {
+                        ShadedMesh& m = *f->mesh;
+                        m.colors.resize(m.z.size());
+                        m.lit.resize(m.z.size());
+                        pool.parallelFor(points.size(), SAMPLE_CHUNK, [&](size_t begin, size_t end) {
+                            if (cancelled) return;
+                            thread_local std::vector<double> xs, ys, z, dx, dy;
+                            thread_local std::vector<uint8_t> ok;
+                            size_t n = end - begin;
+                            xs.resize(n); ys.resize(n); z.resize(n); dx.resize(n); dy.resize(n); ok.resize(n);
+                            for (size_t k = 0; k < n; k++) {
+                                xs[k] = latticeCoord(points[begin + k] / (GRID_MAX + 1));
+                                ys[k] = latticeCoord(points[begin + k] % (GRID_MAX + 1));
+                            }
+                            parser.evalGradBatch(f->prog, xs.data(), ys.data(), z.data(), dx.data(), dy.data(),
+                                                 ok.data(), n);
+                            for (size_t k = 0; k < n; k++) {
+                                int p = points[begin + k];
+                                m.z[p] = z[k];
+                                m.dx[p] = dx[k];
+                                m.dy[p] = dy[k];
+                                m.ok[p] = ok[k];
+                                m.zf[p] = float(z[k]);
+                                m.lit[p] = 0;
+                                m.sampled[p] = 1;
+                            }
+                        });
+                        m.samples += points.size();
+                    };
+                };
+                pool.parallelFor(visible.size(), 1, [&](size_t begin, size_t end) {
+                    for (size_t k = begin; k < end && !cancelled; k++) {
+                        ShadedMesh& m = *visible[k].mesh;
+                        if (m.tolerance != view.tolerance)
+                            tessellateSurface(m, view.tolerance, sampler(visible[k]), cancelled);
+                    }
+                });
+                if (cancelled) return;
+
+                // Per-point colours for every point the leaves use. Filled
+                // surfaces are always shaded.
+                pool.parallelFor(visible.size(), 1, [&](size_t begin, size_t end) {
+                    for (size_t f = begin; f < end && !cancelled; f++) {
+                        Function3D& func = visible[f];
+                        ShadedMesh& m = *func.mesh;
+                        bool shade = view.shading || func.showSurface;
+                        if (m.litShading != shade) {
+                            std::fill(m.lit.begin(), m.lit.end(), 0);
+                            m.litShading = shade;
+                        }
+                        auto light = [&](int i, int j) {
+                            int k = latticeIndex(i, j);
+                            if (m.lit[k]) return;
+                            float h = std::min(std::max((float(m.z[k]) + 2) / 4.0f, 0.f), 1.f);
+                            float c = 0.4f + h * 0.6f;
+                            if (shade) {
+                                // Two-sided Lambert term from the normal (-fx, -fy, 1)
+                                float nx = -m.dx[k], ny = -m.dy[k];
+                                float lambert = std::fabs(nx * LIGHT_X + ny * LIGHT_Y + LIGHT_Z) / std::sqrt(nx * nx + ny * ny + 1);
+                                if (!std::isfinite(lambert)) lambert = 1;
+                                c *= 0.45f + 0.55f * lambert;
+                            }
+                            m.colors[k] = sf::Color(
+                                static_cast<sf::Uint8>(func.color.r * c),
+                                static_cast<sf::Uint8>(func.color.g * c),
+                                static_cast<sf::Uint8>(func.color.b * c)
                             );
-                            lines.push_back({p, color});
-                            lines.push_back({p2, color2});
+                            m.lit[k] = 1;
+                        };
+                        for (auto& c : m.leaves) {
+                            int s = c.size, h = s / 2;
+                            light(c.i, c.j);
+                            light(c.i + s, c.j);
+                            light(c.i + s, c.j + s);
+                            light(c.i, c.j + s);
+                            if (c.finer) {
+                                light(c.i + h, c.j + h);
+                                if (c.finer & 1) light(c.i + h, c.j);
+                                if (c.finer & 2) light(c.i + s, c.j + h);
+                                if (c.finer & 4) light(c.i + h, c.j + s);
+                                if (c.finer & 8) light(c.i, c.j + h);
+                            }
                         }
                     }
-                    
-                    if (j < GRID_SIZE) {
-                        float y2 = -GRID_RANGE + (j + 1) * step;
-                        bool ok2;
-                        float z2 = parser.eval(func.rpn, x, y2, ok2);
-                        if (ok2 && !std::isnan(z2) && !std::isinf(z2) && fabs(z2) < 10) {
-                            auto p2 = project3D({x, y2, z2}, rotX, rotY, scale, origin);
-                            float h2 = std::min(std::max((z2 + 2) / 4.0f, 0.f), 1.f);
-                            sf::Color color2(
-                                static_cast<sf::Uint8>(baseColor.r * (0.4f + h2 * 0.6f)),
-                                static_cast<sf::Uint8>(baseColor.g * (0.4f + h2 * 0.6f)),
-                                static_cast<sf::Uint8>(baseColor.b * (0.4f + h2 * 0.6f))
-                            );
-                            lines.push_back({p, color});
-                            lines.push_back({p2, color2});
+                });
+                if (cancelled) return;
+
+                SurfaceFrame frame;
+                frame.view = view;
+                frame.world = gpu;
+                struct Task { Function3D* func; size_t begin, end; };
+                std::vector<Task> tasks;
+                for (auto& func : visible) {
+                    frame.samples += func.mesh->samples;
+                    frame.leaves += func.mesh->leaves.size();
+                    for (size_t b = 0; b < func.mesh->leaves.size(); b += LEAF_CHUNK)
+                        tasks.push_back({&func, b, std::min(b + LEAF_CHUNK, func.mesh->leaves.size())});
+                }
+                frame.chunks.resize(tasks.size());
+                const Camera cam = Camera::orbit(view.rotX, view.rotY, view.scale, view.origin.x, view.origin.y);
+
+                pool.parallelFor(tasks.size(), 1, [&](size_t begin, size_t end) {
+                    for (size_t t = begin; t < end && !cancelled; t++) {
+                        const Function3D& func = *tasks[t].func;
+                        const ShadedMesh& m = *func.mesh;
+                        SurfaceChunk& chunk = frame.chunks[t];
+
+                        auto point = [&](int k) {
+                            return Point3D(latticeCoord(k / (GRID_MAX + 1)), latticeCoord(k % (GRID_MAX + 1)), m.zf[k]);
+                        };
+
+                        // Without the shader, every lattice point the chunk's
+                        // leaves touch is projected up front in one SoA batch.
+                        thread_local std::vector<sf::Vector2f> screen;
+                        thread_local std::vector<unsigned> stamp;
+                        thread_local unsigned epoch = 0;
+                        thread_local std::vector<int> used;
+                        thread_local std::vector<float> px, py, pz, sx, sy;
+                        if (!frame.world) {
+                            const size_t lattice = size_t(GRID_MAX + 1) * (GRID_MAX + 1);
+                            if (screen.size() != lattice) {
+                                screen.assign(lattice, {});
+                                stamp.assign(lattice, 0);
+                            }
+                            if (++epoch == 0) {
+                                std::fill(stamp.begin(), stamp.end(), 0);
+                                epoch = 1;
+                            }
+                            used.clear();
+                            auto use = [&](int i, int j) {
+                                int k = latticeIndex(i, j);
+                                if (stamp[k] == epoch) return;
+                                stamp[k] = epoch;
+                                used.push_back(k);
+                            };
+                            for (size_t l = tasks[t].begin; l < tasks[t].end; l++) {
+                                const SurfaceLeaf& c = m.leaves[l];
+                                int s = c.size, h = s / 2;
+                                use(c.i, c.j);
+                                use(c.i + s, c.j);
+                                use(c.i + s, c.j + s);
+                                use(c.i, c.j + s);
+                                if (c.finer) use(c.i + h, c.j + h);
+                                if (c.finer & 1) use(c.i + h, c.j);
+                                if (c.finer & 2) use(c.i + s, c.j + h);
+                                if (c.finer & 4) use(c.i + h, c.j + s);
+                                if (c.finer & 8) use(c.i, c.j + h);
+                            }
+                            size_t count = used.size();
+                            px.resize(count); py.resize(count); pz.resize(count); sx.resize(count); sy.resize(count);
+                            for (size_t q = 0; q < count; q++) {
+                                Point3D p = point(used[q]);
+                                px[q] = p.x;
+                                py[q] = p.y;
+                                pz[q] = p.z;
+                            }
+                            cam.projectBatch(px.data(), py.data(), pz.data(), sx.data(), sy.data(), count);
+                            for (size_t q = 0; q < count; q++) screen[used[q]] = {sx[q], sy[q]};
+                        }
+
+                        // World or projected vertex for p, or lattice point k.
+                        auto place = [&](Point3D p, sf::Color c) {
+                            if (frame.world) return sf::Vertex({p.x, p.y}, c, {p.z, 0});
+                            return sf::Vertex(project3D(cam, p), c);
+                        };
+                        auto vertex = [&](int k, sf::Color c) {
+                            if (frame.world) return place(point(k), c);
+                            return sf::Vertex(screen[k], c);
+                        };
+
+                        for (size_t l = tasks[t].begin; l < tasks[t].end; l++) {
+                            const SurfaceLeaf& c = m.leaves[l];
+                            int s = c.size, h = s / 2;
+                            // Boundary counter-clockwise from (i, j), with the
+                            // midpoint of every side whose neighbour is finer.
+                            int ring[8], sideStart[4], n = 0;
+                            const int corner[4][2] = {{c.i, c.j}, {c.i + s, c.j}, {c.i + s, c.j + s}, {c.i, c.j + s}};
+                            const int middle[4][2] = {{c.i + h, c.j}, {c.i + s, c.j + h}, {c.i + h, c.j + s}, {c.i, c.j + h}};
+                            for (int k = 0; k < 4; k++) {
+                                sideStart[k] = n;
+                                ring[n++] = latticeIndex(corner[k][0], corner[k][1]);
+                                if (c.finer & (1 << k)) ring[n++] = latticeIndex(middle[k][0], middle[k][1]);
+                            }
+
+                            // Two triangles, or a fan from the centre when a
+                            // side carries a T-junction; shared by the fill
+                            // and the contours.
+                            int tri[8][3], triangles = 0;
+                            auto addTriangle = [&](int p0, int p1, int p2) {
+                                tri[triangles][0] = p0;
+                                tri[triangles][1] = p1;
+                                tri[triangles][2] = p2;
+                                triangles++;
+                            };
+                            bool drawable = true;
+                            for (int k = 0; k < n; k++) drawable = drawable && latticeUsable(m, ring[k]);
+                            int centre = latticeIndex(c.i + h, c.j + h);
+                            if (c.finer) drawable = drawable && latticeUsable(m, centre);
+                            if (drawable && !c.finer) {
+                                addTriangle(ring[0], ring[1], ring[2]);
+                                addTriangle(ring[0], ring[2], ring[3]);
+                            } else if (drawable) {
+                                for (int k = 0; k < n; k++) addTriangle(centre, ring[k], ring[(k + 1) % n]);
+                            }
+
+                            if (func.showSurface) {
+                                for (int t = 0; t < triangles; t++) {
+                                    for (int k : tri[t]) chunk.fill.push_back(vertex(k, m.colors[k]));
+                                    if (frame.world) continue;
+                                    Point3D pa = point(tri[t][0]), pb = point(tri[t][1]), pd = point(tri[t][2]);
+                                    chunk.fillDepth.push_back(cam.depth((pa.x + pb.x + pd.x) / 3, (pa.y + pb.y + pd.y) / 3,
+                                                                        (pa.z + pb.z + pd.z) / 3));
+                                }
+                            }
+
+                            if (view.contourStep > 0) {
+                                for (int t = 0; t < triangles; t++) {
+                                    contourTriangle(m, tri[t][0], tri[t][1], tri[t][2], view.contourStep,
+                                                    [&](double level, double x0, double y0, double x1, double y1) {
+                                        // Tinted by the level like the surface by its height.
+                                        float k = 0.4f + 0.6f * std::min(std::max((float(level) + 2) / 4.0f, 0.f), 1.f);
+                                        sf::Color col(static_cast<sf::Uint8>(func.color.r * k), static_cast<sf::Uint8>(func.color.g * k),
+                                                      static_cast<sf::Uint8>(func.color.b * k));
+                                        chunk.vertices.push_back(place(Point3D(x0, y0, CONTOUR_FLOOR), col));
+                                        chunk.vertices.push_back(place(Point3D(x1, y1, CONTOUR_FLOOR), col));
+                                    });
+                                }
+                            }
+
+                            // World form chains the wireframe per surface below.
+                            if (func.showWireframe && !frame.world) {
+                                for (int k = 0; k < 4; k++) {
+                                    if (!leafDrawsSide(c, k)) continue;
+                                    int a = ring[sideStart[k]], b = ring[(sideStart[k] + 1) % n];
+                                    if (!latticeUsable(m, a) || !latticeUsable(m, b)) continue;
+                                    chunk.vertices.push_back(vertex(a, wireColor(m, a, func.showSurface)));
+                                    chunk.vertices.push_back(vertex(b, wireColor(m, b, func.showSurface)));
+                                }
+                            }
                         }
                     }
+                });
+                if (cancelled) return;
+
+                if (frame.world) {
+                    frame.wires.resize(visible.size());
+                    pool.parallelFor(visible.size(), 1, [&](size_t begin, size_t end) {
+                        for (size_t f = begin; f < end && !cancelled; f++) {
+                            const Function3D& func = visible[f];
+                            if (!func.showWireframe) continue;
+                            const ShadedMesh& m = *func.mesh;
+                            SurfaceWire& wire = frame.wires[f];
+                            wireframeStrips(m, [&](const int* points, size_t n) {
+                                for (size_t q = 0; q < n; q++) {
+                                    int k = points[q];
+                                    wire.vertices.push_back({{latticeCoord(k / (GRID_MAX + 1)), latticeCoord(k % (GRID_MAX + 1))},
+                                                             wireColor(m, k, func.showSurface), {m.zf[k], 0}});
+                                }
+                                wire.runs.push_back(n);
+                            });
+                        }
+                    });
+                    if (cancelled) return;
                 }
+
+                // Painter's algorithm for the projected form: every triangle
+                // of every surface, furthest first.
+                if (!frame.world) {
+                    std::vector<std::pair<float, const sf::Vertex*>> triangles;
+                    for (auto& chunk : frame.chunks)
+                        for (size_t k = 0; k < chunk.fillDepth.size(); k++)
+                            triangles.push_back({chunk.fillDepth[k], &chunk.fill[3 * k]});
+                    std::sort(triangles.begin(), triangles.end(),
+                              [](const auto& a, const auto& b) { return a.first > b.first; });
+                    frame.fill.reserve(triangles.size() * 3);
+                    for (auto& t : triangles) frame.fill.insert(frame.fill.end(), t.second, t.second + 3);
+                    for (auto& chunk : frame.chunks) {
+                        chunk.fill.clear();
+                        chunk.fillDepth.clear();
+                    }
+                }
+                frames.put(std::move(frame));
+            });
+        }
+        if (frames.take(shown)) {
+            shownSamples = shown.samples;
+            shownLeaves = shown.leaves;
+            if (shown.world) {
+                surfaceCount = uploadVertices(shown, &SurfaceChunk::vertices, surfaceBuffer);
+                uploadStrips(shown, wireBuffer, wireRuns);
+                fillCount = uploadVertices(shown, &SurfaceChunk::fill, fillBuffer);
             }
-            
-            if (!lines.empty()) {
-                win.draw(&lines[0], lines.size(), sf::Lines);
+        }
+        if (shown.world) {
+            const Camera cam = Camera::orbit(rotX, rotY, scale, origin.x, origin.y);
+            float m[16];
+            for (int r = 0; r < 4; r++)
+                for (int k = 0; k < 4; k++) m[k * 4 + r] = cam.m[r][k];  // column-major
+            surfaceShader.setUniform("camera", sf::Glsl::Mat4(m));
+            // Filled surfaces need the depth buffer; SFML leaves it alone,
+            // so it is switched on only around these draws.
+            bool depth = fillCount > 0;
+            if (depth) {
+                win.setActive(true);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                glEnable(GL_DEPTH_TEST);
+                glDepthFunc(GL_LEQUAL);
+                surfaceShader.setUniform("depthBias", 0.f);
+                win.draw(fillBuffer, 0, fillCount, &surfaceShader);
+            }
+            surfaceShader.setUniform("depthBias", -0.001f);
+            if (surfaceCount > 0) win.draw(surfaceBuffer, 0, surfaceCount, &surfaceShader);
+            for (auto& run : wireRuns) win.draw(wireBuffer, run.first, run.second, &surfaceShader);
+            if (depth) glDisable(GL_DEPTH_TEST);
+        } else {
+            sf::Transform reproject;
+            if (shown.view.rotX == rotX && shown.view.rotY == rotY && shown.view.scale > 0) {
+                float k = scale / shown.view.scale;
+                reproject.translate(origin).scale(k, k).translate(-shown.view.origin);
             }
+            if (!shown.fill.empty()) win.draw(&shown.fill[0], shown.fill.size(), sf::Triangles, reproject);
+            for (auto& chunk : shown.chunks)
+                if (!chunk.vertices.empty()) win.draw(&chunk.vertices[0], chunk.vertices.size(), sf::Lines, reproject);
         }
         
         // Draw 3D axes
         if (showAxes) {
-            auto axisX1 = project3D({-GRID_RANGE, 0, 0}, rotX, rotY, scale, origin);
-            auto axisX2 = project3D({GRID_RANGE, 0, 0}, rotX, rotY, scale, origin);
-            auto axisY1 = project3D({0, -GRID_RANGE, 0}, rotX, rotY, scale, origin);
-            auto axisY2 = project3D({0, GRID_RANGE, 0}, rotX, rotY, scale, origin);
-            auto axisZ1 = project3D({0, 0, -GRID_RANGE}, rotX, rotY, scale, origin);
-            auto axisZ2 = project3D({0, 0, GRID_RANGE}, rotX, rotY, scale, origin);
+            const Camera cam = Camera::orbit(rotX, rotY, scale, origin.x, origin.y);
+            auto axisX1 = project3D(cam, {-GRID_RANGE, 0, 0});
+            auto axisX2 = project3D(cam, {GRID_RANGE, 0, 0});
+            auto axisY1 = project3D(cam, {0, -GRID_RANGE, 0});
+            auto axisY2 = project3D(cam, {0, GRID_RANGE, 0});
+            auto axisZ1 = project3D(cam, {0, 0, -GRID_RANGE});
+            auto axisZ2 = project3D(cam, {0, 0, GRID_RANGE});
             
             sf::Vertex axes[] = {
                 {axisX1, {255, 80, 80}}, {axisX2, {255, 80, 80}},
@@ -726,7 +1052,8 @@ int main() {
             statusTxt.setCharacterSize(12);
             statusTxt.setFillColor({90, 90, 90});
             statusTxt.setString("Functions: " + std::to_string(functions.size()) + 
-                              " | Grid Resolution: " + std::to_string(GRID_SIZE) + "x" + std::to_string(GRID_SIZE));
+                              " | Samples: " + std::to_string(shownSamples) +
+                              " | Cells: " + std::to_string(shownLeaves));
             statusTxt.setPosition(15, 873);
             win.draw(statusTxt);
         }
@@ -0,0 +1,504 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "parser.hpp"
+
+#if defined(SIMD_X86) && (defined(__linux__) || defined(__APPLE__)) && !defined(GRAFIK_NO_JIT)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+// ============================================================================
+// JIT - kode mesin x86-64 untuk Program
+// ============================================================================
+
+// Native entry points. The scalar function mirrors Parser::eval(): *ok is
+// set to 0 when a division by zero occurred. The batch function processes
+// nVec groups of four samples.
+typedef double (*JitScalarFn)(double x, double y, uint8_t* ok);
+typedef void (*JitBatchFn)(const double* xs, const double* ys, double* out, uint8_t* ok, size_t nVec);
+
+#ifdef JIT_X86_64
+
+// Minimal encoder for the handful of x86-64 and AVX instructions the
+// code generator needs. Memory operands are always [base + disp32].
+class X64Emitter {
+public:
+    enum Gpr { RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+    enum Pp { PP_NONE = 0, PP_66 = 1, PP_F3 = 2, PP_F2 = 3 };
+    enum Map { MAP_0F = 1, MAP_0F3A = 3 };
+
+    std::vector<uint8_t> buf;
+
+    size_t size() const { return buf.size(); }
+    void byte(uint8_t b) { buf.push_back(b); }
+    void dword(uint32_t v) { for (int i = 0; i < 4; i++) byte(uint8_t(v >> (8 * i))); }
+    void qword(uint64_t v) { for (int i = 0; i < 8; i++) byte(uint8_t(v >> (8 * i))); }
+
+    // VEX register-register form: reg <- op(vvvv, rm).
+    void vexRR(Pp pp, Map map, uint8_t op, bool l256, int reg, int vvvv, int rm) {
+        vex(pp, map, l256, reg, vvvv, rm);
+        byte(op);
+        byte(uint8_t(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+    }
+
+    // VEX register-memory form: reg <- op(vvvv, [base + disp]).
+    void vexRM(Pp pp, Map map, uint8_t op, bool l256, int reg, int vvvv, int base, int32_t disp) {
+        vex(pp, map, l256, reg, vvvv, base);
+        byte(op);
+        mem(reg, base, disp);
+    }
+
+    void vzeroupper() { byte(0xC5); byte(0xF8); byte(0x77); }
+
+    void push(int r) { if (r >= 8) byte(0x41); byte(uint8_t(0x50 + (r & 7))); }
+    void pop(int r)  { if (r >= 8) byte(0x41); byte(uint8_t(0x58 + (r & 7))); }
+
+    void movImm64(int r, uint64_t v) {
+        byte(uint8_t(0x48 | (r >> 3)));
+        byte(uint8_t(0xB8 + (r & 7)));
+        qword(v);
+    }
+
+    void movRR(int dst, int src) {
+        byte(uint8_t(0x48 | ((src >> 3) << 2) | (dst >> 3)));
+        byte(0x89);
+        byte(uint8_t(0xC0 | ((src & 7) << 3) | (dst & 7)));
+    }
+
+    void addImm(int r, int32_t v) { aluImm(0, r, v); }
+    void subImm(int r, int32_t v) { aluImm(5, r, v); }
+
+    void callReg(int r) {
+        if (r >= 8) byte(0x41);
+        byte(0xFF);
+        byte(uint8_t(0xD0 | (r & 7)));
+    }
+
+    // jnz back to `target` (an earlier offset).
+    void jnzTo(size_t target) {
+        byte(0x0F); byte(0x85);
+        dword(uint32_t(int32_t(target) - int32_t(size() + 4)));
+    }
+
+    void imulEaxImm(uint32_t v) { byte(0x69); byte(0xC0); dword(v); }
+    void andEaxImm(uint32_t v) { byte(0x25); dword(v); }
+
+    void storeEax(int base, int32_t disp) { rex(0, base, false); byte(0x89); mem(RAX, base, disp); }
+    void storeAl(int base, int32_t disp)  { rex(0, base, false); byte(0x88); mem(RAX, base, disp); }
+    void storeImm32(int base, int32_t disp, uint32_t v) { rex(0, base, false); byte(0xC7); mem(0, base, disp); dword(v); }
+    void storeImm8(int base, int32_t disp, uint8_t v)   { rex(0, base, false); byte(0xC6); mem(0, base, disp); byte(v); }
+
+    void ret() { byte(0xC3); }
+
+private:
+    void vex(Pp pp, Map map, bool l256, int reg, int vvvv, int rm) {
+        byte(0xC4);
+        byte(uint8_t(((~reg >> 3) & 1) << 7 | 1 << 6 | ((~rm >> 3) & 1) << 5 | map));
+        byte(uint8_t((~vvvv & 15) << 3 | (l256 ? 4 : 0) | pp));
+    }
+
+    void rex(int reg, int base, bool w) {
+        uint8_t r = uint8_t(0x40 | (w ? 8 : 0) | ((reg >> 3) << 2) | (base >> 3));
+        if (r != 0x40) byte(r);
+    }
+
+    void mem(int reg, int base, int32_t disp) {
+        byte(uint8_t(0x80 | ((reg & 7) << 3) | (base & 7)));
+        if ((base & 7) == RSP) byte(0x24);
+        dword(uint32_t(disp));
+    }
+
+    void aluImm(int ext, int r, int32_t v) {
+        byte(uint8_t(0x48 | (r >> 3)));
+        byte(0x81);
+        byte(uint8_t(0xC0 | (ext << 3) | (r & 7)));
+        dword(uint32_t(v));
+    }
+};
+
+// Generates one function for a Program, either scalar (SSE-width VEX
+// instructions, libm calls) or batch (four lanes in ymm registers, calls
+// into the AVX2 kernels of simd.hpp). Virtual register r lives in
+// xmm/ymm(r + 2); xmm0/xmm1 are scratch and call arguments. Registers that
+// stay live across a call are spilled to the stack frame around it.
+class JitCodegen {
+public:
+    static const int MAX_REGS = 14;
+
+    JitCodegen(const Program& prog, bool vector, uint64_t data, const std::vector<size_t>& constOff,
+               size_t signOff, size_t absOff, size_t onesOff)
+        : prog(prog), vector(vector), data(data), constOff(constOff),
+          signOff(signOff), absOff(absOff), onesOff(onesOff) {}
+
+    void generate(X64Emitter& e) {
+        R = prog.regCount;
+        okSlot = 32 * R;
+        tmpSlot = okSlot + 32;
+        xSlot = tmpSlot + 32;
+        ySlot = xSlot + 32;
+        frame = ySlot + 32 + 8;   // six pushes leave rsp 8 mod 16
+        hasDiv = false;
+        for (const Instr& in : prog.code) hasDiv |= in.op == OP_DIV;
+        liveness();
+
+        const int saved[] = {X64Emitter::RBX, X64Emitter::RBP, X64Emitter::R12,
+                             X64Emitter::R13, X64Emitter::R14, X64Emitter::R15};
+        for (int r : saved) e.push(r);
+        e.subImm(X64Emitter::RSP, frame);
+        e.movImm64(X64Emitter::RBP, data);
+
+        size_t loop = 0;
+        if (vector) {
+            e.movRR(X64Emitter::R12, X64Emitter::RDI);
+            e.movRR(X64Emitter::R13, X64Emitter::RSI);
+            e.movRR(X64Emitter::R14, X64Emitter::RDX);
+            e.movRR(X64Emitter::R15, X64Emitter::RCX);
+            e.movRR(X64Emitter::RBX, X64Emitter::R8);
+            loop = e.size();
+        } else {
+            e.vzeroupper();
+            e.movRR(X64Emitter::R15, X64Emitter::RDI);
+            store(e, 0, X64Emitter::RSP, xSlot);
+            store(e, 1, X64Emitter::RSP, ySlot);
+        }
+
+        if (hasDiv) {
+            load(e, 0, X64Emitter::RBP, int32_t(onesOff));
+            store(e, 0, X64Emitter::RSP, okSlot);
+        }
+        for (size_t i = 0; i < prog.code.size(); i++) instr(e, i);
+
+        if (hasDiv) {
+            load(e, 0, X64Emitter::RSP, okSlot);
+            e.vexRR(X64Emitter::PP_66, X64Emitter::MAP_0F, 0x50, vector, X64Emitter::RAX, 0, 0);
+        }
+        if (vector) {
+            e.vexRM(X64Emitter::PP_66, X64Emitter::MAP_0F, 0x11, true, phys(prog.result), 0, X64Emitter::R14, 0);
+            if (hasDiv) {
+                // Spread the four mask bits into four 0/1 bytes.
+                e.imulEaxImm(0x00204081);
+                e.andEaxImm(0x01010101);
+                e.storeEax(X64Emitter::R15, 0);
+            } else {
+                e.storeImm32(X64Emitter::R15, 0, 0x01010101);
+            }
+            e.addImm(X64Emitter::R12, 32);
+            e.addImm(X64Emitter::R13, 32);
+            e.addImm(X64Emitter::R14, 32);
+            e.addImm(X64Emitter::R15, 4);
+            e.subImm(X64Emitter::RBX, 1);
+            e.jnzTo(loop);
+        } else {
+            if (hasDiv) {
+                e.andEaxImm(1);
+                e.storeAl(X64Emitter::R15, 0);
+            } else {
+                e.storeImm8(X64Emitter::R15, 0, 1);
+            }
+            e.vexRR(X64Emitter::PP_66, X64Emitter::MAP_0F, 0x28, false, 0, 0, phys(prog.result));
+        }
+
+        e.vzeroupper();
+        e.addImm(X64Emitter::RSP, frame);
+        for (int i = 5; i >= 0; i--) e.pop(saved[i]);
+        e.ret();
+    }
+
+private:
+    const Program& prog;
+    bool vector;
+    uint64_t data;
+    const std::vector<size_t>& constOff;
+    size_t signOff, absOff, onesOff;
+    int R = 0, okSlot = 0, tmpSlot = 0, xSlot = 0, ySlot = 0, frame = 0;
+    bool hasDiv = false;
+    std::vector<uint64_t> liveAfter;
+
+    static int phys(int r) { return r + 2; }
+    X64Emitter::Pp arithPp() const { return vector ? X64Emitter::PP_66 : X64Emitter::PP_F2; }
+
+    // vmovupd (vector) or vmovsd (scalar) between a register and memory.
+    void load(X64Emitter& e, int x, int base, int32_t disp) {
+        e.vexRM(arithPp(), X64Emitter::MAP_0F, 0x10, vector, x, 0, base, disp);
+    }
+
+    void store(X64Emitter& e, int x, int base, int32_t disp) {
+        e.vexRM(arithPp(), X64Emitter::MAP_0F, 0x11, vector, x, 0, base, disp);
+    }
+
+    void move(X64Emitter& e, int dst, int src) {
+        if (dst != src) e.vexRR(X64Emitter::PP_66, X64Emitter::MAP_0F, 0x28, vector, dst, 0, src);
+    }
+
+    void arith(X64Emitter& e, uint8_t op, int dst, int a, int b) {
+        e.vexRR(arithPp(), X64Emitter::MAP_0F, op, vector, dst, a, b);
+    }
+
+    void logicMem(X64Emitter& e, uint8_t op, int dst, int a, int base, size_t disp) {
+        e.vexRM(X64Emitter::PP_66, X64Emitter::MAP_0F, op, vector, dst, a, base, int32_t(disp));
+    }
+
+    void liveness() {
+        liveAfter.assign(prog.code.size(), 0);
+        uint64_t live = uint64_t(1) << prog.result;
+        for (size_t i = prog.code.size(); i-- > 0;) {
+            const Instr& in = prog.code[i];
+            liveAfter[i] = live;
+            live &= ~(uint64_t(1) << in.dst);
+            if (in.op >= OP_ADD) live |= uint64_t(1) << in.a;
+            if (in.op >= OP_ADD && in.op <= OP_POW) live |= uint64_t(1) << in.b;
+        }
+    }
+
+    void spill(X64Emitter& e, uint64_t regs, bool restore) {
+        for (int r = 0; r < R; r++) {
+            if (!(regs >> r & 1)) continue;
+            if (restore) load(e, phys(r), X64Emitter::RSP, 32 * r);
+            else store(e, phys(r), X64Emitter::RSP, 32 * r);
+        }
+    }
+
+    void call(X64Emitter& e, const void* fn) {
+        e.movImm64(X64Emitter::RAX, uint64_t(uintptr_t(fn)));
+        e.callReg(X64Emitter::RAX);
+    }
+
+    void instr(X64Emitter& e, size_t i) {
+        const Instr& in = prog.code[i];
+        int d = phys(in.dst), a = phys(in.a), b = phys(in.b);
+        uint64_t keep = liveAfter[i] & ~(uint64_t(1) << in.dst);
+
+        switch (in.op) {
+            case OP_CONST: load(e, d, X64Emitter::RBP, int32_t(constOff[in.arg])); break;
+            case OP_X:
+                if (vector) load(e, d, X64Emitter::R12, 0);
+                else load(e, d, X64Emitter::RSP, xSlot);
+                break;
+            case OP_Y:
+                if (vector) load(e, d, X64Emitter::R13, 0);
+                else load(e, d, X64Emitter::RSP, ySlot);
+                break;
+            case OP_ADD: arith(e, 0x58, d, a, b); break;
+            case OP_SUB: arith(e, 0x5C, d, a, b); break;
+            case OP_MUL: arith(e, 0x59, d, a, b); break;
+            case OP_DIV:
+                // mask = b != 0; ok &= mask; d = (a / b) & mask
+                e.vexRR(X64Emitter::PP_66, X64Emitter::MAP_0F, 0x57, vector, 0, 0, 0);
+                arith(e, 0xC2, 1, b, 0);
+                e.byte(4);
+                e.vexRM(X64Emitter::PP_66, X64Emitter::MAP_0F, 0x54, vector, 0, 1, X64Emitter::RSP, okSlot);
+                store(e, 0, X64Emitter::RSP, okSlot);
+                arith(e, 0x5E, 0, a, b);
+                e.vexRR(X64Emitter::PP_66, X64Emitter::MAP_0F, 0x54, vector, d, 0, 1);
+                break;
+            case OP_NEG: logicMem(e, 0x57, d, a, X64Emitter::RBP, signOff); break;
+            case OP_POW:
+                spill(e, keep, false);
+                move(e, 0, a);
+                move(e, 1, b);
+                call(e, vector ? (const void*)&simd_avx2::powLane : (const void*)&jitPow);
+                move(e, d, 0);
+                spill(e, keep, true);
+                break;
+            case OP_CALL:
+                callBuiltin(e, in.arg, d, a, keep);
+                break;
+        }
+    }
+
+    static double jitPow(double a, double b) { return pow(a, b); }
+
+    static const void* laneFn(int id) {
+        switch (id) {
+            case FN_SIN:   return (const void*)&simd_avx2::sinLane;
+            case FN_COS:   return (const void*)&simd_avx2::cosLane;
+            case FN_SINH:  return (const void*)&simd_avx2::sinhLane;
+            case FN_COSH:  return (const void*)&simd_avx2::coshLane;
+            case FN_TANH:  return (const void*)&simd_avx2::tanhV;
+            case FN_EXP:   return (const void*)&simd_avx2::expV;
+            case FN_LN:    return (const void*)&simd_avx2::logV;
+            case FN_LOG:   return (const void*)&simd_avx2::log10L;
+            default:       return nullptr;
+        }
+    }
+
+    void callBuiltin(X64Emitter& e, int id, int d, int a, uint64_t keep) {
+        switch (id) {
+            case FN_SQRT:
+                e.vexRR(arithPp(), X64Emitter::MAP_0F, 0x51, vector, d, vector ? 0 : a, a);
+                return;
+            case FN_ABS:
+                logicMem(e, 0x54, d, a, X64Emitter::RBP, absOff);
+                return;
+            case FN_FLOOR:
+            case FN_CEIL:
+                // vroundpd / vroundsd with an explicit mode, inexact suppressed
+                e.vexRR(X64Emitter::PP_66, X64Emitter::MAP_0F3A, vector ? 0x09 : 0x0B, vector,
+                        d, vector ? 0 : a, a);
+                e.byte(id == FN_FLOOR ? 0x09 : 0x0A);
+                return;
+        }
+
+        spill(e, keep, false);
+        const void* lane = vector ? laneFn(id) : nullptr;
+        if (!vector || lane) {
+            move(e, 0, a);
+            call(e, vector ? lane : (const void*)builtins()[id].fn);
+            move(e, d, 0);
+        } else {
+            // No vector kernel: four scalar libm calls through the frame.
+            store(e, a, X64Emitter::RSP, tmpSlot);
+            e.vzeroupper();
+            for (int l = 0; l < 4; l++) {
+                e.vexRM(X64Emitter::PP_F2, X64Emitter::MAP_0F, 0x10, false, 0, 0, X64Emitter::RSP, tmpSlot + 8 * l);
+                call(e, (const void*)builtins()[id].fn);
+                e.vexRM(X64Emitter::PP_F2, X64Emitter::MAP_0F, 0x11, false, 0, 0, X64Emitter::RSP, tmpSlot + 8 * l);
+            }
+            load(e, d, X64Emitter::RSP, tmpSlot);
+        }
+        spill(e, keep, true);
+    }
+};
+
+#endif // JIT_X86_64
+
+// Program plus optional native code. compile() returns false when no JIT
+// is available (non-x86-64 build, CPU without AVX2/FMA, executable memory
+// refused, or too many registers); eval()/evalBatch() then fall back to
+// the Parser interpreter, so callers never need to branch.
+class JitProgram {
+public:
+    bool compile(const Program& p) {
+        prog = p;
+        mem.reset();
+        scalarFn = nullptr;
+        batchFn = nullptr;
+#ifdef JIT_X86_64
+        if (!available() || prog.empty() || prog.regCount > JitCodegen::MAX_REGS) return false;
+
+        // Data block: every constant replicated to 32 bytes so both the
+        // scalar and the vector code can load it directly, then the masks.
+        std::vector<double> data;
+        std::vector<size_t> constOff;
+        auto put = [&](double v) {
+            size_t off = data.size() * sizeof(double);
+            for (int l = 0; l < 4; l++) data.push_back(v);
+            return off;
+        };
+        auto bits = [](uint64_t b) { double v; memcpy(&v, &b, sizeof v); return v; };
+        for (double c : prog.consts) constOff.push_back(put(c));
+        size_t signOff = put(-0.0);
+        size_t absOff = put(bits(0x7FFFFFFFFFFFFFFFULL));
+        size_t onesOff = put(bits(~0ULL));
+        size_t dataBytes = data.size() * sizeof(double);
+
+        // Generate once to learn the code size, then again at the final
+        // addresses (the data block is referenced by absolute address).
+        size_t page = 4096;
+        X64Emitter scalar, batch;
+        for (int pass = 0; pass < 2; pass++) {
+            uint64_t base = uint64_t(uintptr_t(mem.get()));
+            scalar.buf.clear();
+            batch.buf.clear();
+            JitCodegen(prog, false, base, constOff, signOff, absOff, onesOff).generate(scalar);
+            JitCodegen(prog, true, base, constOff, signOff, absOff, onesOff).generate(batch);
+            if (pass == 1) break;
+
+            size_t bytes = (dataBytes + scalar.size() + batch.size() + 64 + page - 1) / page * page;
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) return false;
+            mem.reset((uint8_t*)p, [bytes](uint8_t* q) { munmap(q, bytes); });
+            memSize = bytes;
+        }
+
+        uint8_t* m = mem.get();
+        size_t scalarAt = (dataBytes + 31) / 32 * 32;
+        size_t batchAt = (scalarAt + scalar.size() + 31) / 32 * 32;
+        memcpy(m, data.data(), dataBytes);
+        memcpy(m + scalarAt, scalar.buf.data(), scalar.size());
+        memcpy(m + batchAt, batch.buf.data(), batch.size());
+        if (mprotect(m, memSize, PROT_READ | PROT_EXEC) != 0) {
+            mem.reset();
+            return false;
+        }
+        scalarFn = (JitScalarFn)(void*)(m + scalarAt);
+        batchFn = (JitBatchFn)(void*)(m + batchAt);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // True when this CPU and platform can run generated code.
+    static bool available() {
+#ifdef JIT_X86_64
+        static const bool ok = cpuHasAvx2();
+        return ok;
+#else
+        return false;
+#endif
+    }
+
+    bool ready() const { return scalarFn != nullptr; }
+    const Program& program() const { return prog; }
+
+    // Native double(x, y) entry point, or null when not compiled.
+    JitScalarFn function() const { return scalarFn; }
+
+    double eval(double x, double y, bool& ok) const {
+        if (!scalarFn) return Parser().eval(prog, x, y, ok);
+        uint8_t k;
+        double v = scalarFn(x, y, &k);
+        ok = k != 0;
+        return v;
+    }
+
+    void evalBatch(const double* xs, double* out, uint8_t* okMask, size_t n) const {
+        evalBatch(xs, nullptr, out, okMask, n);
+    }
+
+    // Same contract as Parser::evalBatch.
+    void evalBatch(const double* xs, const double* ys, double* out, uint8_t* okMask, size_t n) const {
+        if (!batchFn) {
+            Parser().evalBatch(prog, xs, ys, out, okMask, n);
+            return;
+        }
+        if (!ys) {
+            if (prog.usesY) {
+                static thread_local std::vector<double> zeros;
+                if (zeros.size() < n) zeros.resize(n, 0.0);
+                ys = zeros.data();
+            } else {
+                ys = xs;   // never read
+            }
+        }
+        size_t full = n / 4;
+        if (full) batchFn(xs, ys, out, okMask, full);
+        size_t i = full * 4;
+        if (i < n) {
+            double tx[4], ty[4], to[4];
+            uint8_t tk[4];
+            for (size_t l = 0; l < 4; l++) {
+                tx[l] = xs[std::min(i + l, n - 1)];
+                ty[l] = ys[std::min(i + l, n - 1)];
+            }
+            batchFn(tx, ty, to, tk, 1);
+            for (size_t l = 0; i + l < n; l++) {
+                out[i + l] = to[l];
+                okMask[i + l] = tk[l];
+            }
+        }
+    }
+
+private:
+    Program prog;
+    std::shared_ptr<uint8_t> mem;
+    size_t memSize = 0;
+    JitScalarFn scalarFn = nullptr;
+    JitBatchFn batchFn = nullptr;
+};
@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 
+#include "samples.hpp"
+
 
 
 int main() {
@@ -134,15 +136,19 @@ int main() {
     // ===== MEMBUAT TITIK-TITIK GRAFIK FUNGSI =====
     std::vector<sf::Vertex> graphPoints;  // Vector untuk menyimpan titik-titik grafik
     
-    // Loop untuk menghitung titik-titik grafik
-    // Dari x = -10 sampai x = 10 dengan step kecil
-    for (float x = -10.0f; x <= 10.0f; x += 0.01f) {
-        // Hitung nilai y dari fungsi (dalam hal ini y = sin(x))
-        float y = std::sin(x);
-        
+    // Titik-titik dihitung secara adaptif dari x = -10 sampai x = 10:
+    // mulai dengan 40 interval kasar, lalu interval dipecah hanya jika
+    // kurva menyimpang lebih dari setengah pixel dari garis lurusnya
+    CurveTolerance tol{scaleX, scaleY};
+    std::vector<CurvePoint> samples = sampleCurve([](double x, double& y) {
+        y = std::sin(x);  // Fungsi yang digambar: y = sin(x)
+        return true;
+    }, -10.0, 10.0, tol, 40);
+    
+    for (const CurvePoint& p : samples) {
         // Konversi dari koordinat matematika ke koordinat layar
-        float screenX = centerX + (x * scaleX);  // Koordinat X di layar
-        float screenY = centerY - (y * scaleY);  // Koordinat Y di layar (minus karena Y layar terbalik)
+        float screenX = centerX + (float(p.x) * scaleX);  // Koordinat X di layar
+        float screenY = centerY - (float(p.y) * scaleY);  // Koordinat Y di layar (minus karena Y layar terbalik)
         
         // Tambahkan vertex (titik) ke vector dengan warna merah
         graphPoints.push_back(sf::Vertex(sf::Vector2f(screenX, screenY), sf::Color::Red));
@@ -3,6 +3,9 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+
+#include "samples.hpp"
 
 class GraphPlotter
 {
@@ -159,25 +162,38 @@ public:
   // Gambar fungsi matematika
   void plotFunction(float (*func)(float), sf::Color color, const std::string &name)
   {
-    std::vector<sf::Vertex> points;
-    float step = (xMax - xMin) / (width * 2); // Lebih banyak titik untuk kurva halus
+    // Sampling adaptif: mulai kasar (tiap ~16 px), dipecah hanya di bagian
+    // yang melengkung atau terputus
+    CurveTolerance tol{width / (xMax - xMin), height / (yMax - yMin)};
+    std::vector<CurvePoint> samples = sampleCurve([&](double x, double &y)
+                                                  {
+                                                    y = func(float(x));
+                                                    return true;
+                                                  },
+                                                  xMin, xMax, tol, std::max(1, int(width / 16)));
 
-    for (float x = xMin; x <= xMax; x += step)
+    std::vector<sf::Vertex> points;
+    auto flush = [&]()
     {
-      float y = func(x);
+      if (points.size() > 1)
+        window.draw(&points[0], points.size(), sf::LineStrip);
+      points.clear();
+    };
 
+    for (const CurvePoint &p : samples)
+    {
       // Pastikan y dalam range
-      if (y >= yMin && y <= yMax && !std::isnan(y) && !std::isinf(y))
+      if (p.ok && p.y >= yMin && p.y <= yMax)
       {
-        sf::Vector2f pos = mathToScreen(x, y);
+        sf::Vector2f pos = mathToScreen(float(p.x), float(p.y));
         points.push_back(sf::Vertex(pos, color));
       }
+      else if (!p.ok)
+      {
+        flush();
+      }
     }
-
-    if (points.size() > 1)
-    {
-      window.draw(&points[0], points.size(), sf::LineStrip);
-    }
+    flush();
   }
 
   // Gambar legenda
@@ -0,0 +1,1251 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "simd.hpp"
+
+// ============================================================================
+// STRUKTUR DATA
+// ============================================================================
+
+struct Token {
+    enum Type { NUMBER, VAR_X, VAR_Y, OP, FUNC, LPAREN, RPAREN } type;
+    double value{};
+    std::string text;
+    int precedence{};
+    bool rightAssoc{};
+};
+
+// Kode register: dst = a op b (hanya a untuk operasi unary). Operand arg
+// menunjuk ke pool konstanta untuk OP_CONST atau ke tabel builtin untuk
+// OP_CALL.
+enum OpCode : uint8_t {
+    OP_CONST, OP_X, OP_Y,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW,
+    OP_CALL, OP_NEG
+};
+
+struct Instr {
+    OpCode op;
+    uint8_t dst, a, b;
+    uint16_t arg;
+};
+
+struct Program {
+    std::vector<Instr> code;
+    std::vector<double> consts;
+    int regCount = 0;
+    int result = 0;       // register holding the value after the last instruction
+    bool usesY = false;
+
+    bool empty() const { return code.empty(); }
+    void clear() { code.clear(); consts.clear(); regCount = 0; result = 0; usesY = false; }
+};
+
+// Hasil evaluasi dual number: nilai dan turunan d/dx.
+struct Dual {
+    double v, d;
+};
+
+// Nilai dan gradien (df/dx, df/dy) untuk permukaan 3D.
+struct Grad {
+    double v, dx, dy;
+};
+
+// Selang untuk evaluasi interval: [lo, hi] mengurung f di seluruh kotak
+// input. lo > hi berarti kosong (f tidak terdefinisi di mana pun).
+// defined is false when some point of the box may be outside f's domain;
+// continuous is false when f may jump or have a pole inside the box.
+struct Interval {
+    double lo, hi;
+    bool defined = true;
+    bool continuous = true;
+
+    static Interval point(double v) { return {v, v}; }
+    static Interval none() { return {INFINITY, -INFINITY, false, true}; }
+    bool empty() const { return lo > hi; }
+    bool contains(double v) const { return lo <= v && v <= hi; }
+};
+
+// ============================================================================
+// FUNGSI BUILTIN
+// ============================================================================
+
+typedef double (*UnaryFn)(double);
+typedef void (*ColumnFn)(double* d, const double* a, size_t n);
+
+enum BuiltinId : uint16_t {
+    FN_SIN, FN_COS, FN_TAN, FN_ASIN, FN_ACOS, FN_ATAN,
+    FN_SINH, FN_COSH, FN_TANH, FN_EXP, FN_LN, FN_LOG,
+    FN_SQRT, FN_ABS, FN_FLOOR, FN_CEIL,
+    FN_COUNT
+};
+
+// fn is the scalar libm call; column is the vector kernel used by
+// evalBatch, or null when the builtin has none and is mapped lane by lane.
+struct Builtin {
+    const char* name;
+    UnaryFn fn;
+    ColumnFn column;
+};
+
+inline const Builtin* builtins() {
+    static const SimdKernels& k = simdKernels();
+    static const Builtin table[FN_COUNT] = {
+        {"sin",   [](double x) { return sin(x); },   k.sin},
+        {"cos",   [](double x) { return cos(x); },   k.cos},
+        {"tan",   [](double x) { return tan(x); },   nullptr},
+        {"asin",  [](double x) { return asin(x); },  nullptr},
+        {"acos",  [](double x) { return acos(x); },  nullptr},
+        {"atan",  [](double x) { return atan(x); },  nullptr},
+        {"sinh",  [](double x) { return sinh(x); },  k.sinh},
+        {"cosh",  [](double x) { return cosh(x); },  k.cosh},
+        {"tanh",  [](double x) { return tanh(x); },  k.tanh},
+        {"exp",   [](double x) { return exp(x); },   k.exp},
+        {"ln",    [](double x) { return log(x); },   k.ln},
+        {"log",   [](double x) { return log10(x); }, k.log10},
+        {"sqrt",  [](double x) { return sqrt(x); },  k.sqrt},
+        {"abs",   [](double x) { return fabs(x); },  k.abs},
+        {"floor", [](double x) { return floor(x); }, k.floor},
+        {"ceil",  [](double x) { return ceil(x); },  k.ceil}
+    };
+    return table;
+}
+
+inline int findBuiltin(const std::string& name) {
+    for (int i = 0; i < FN_COUNT; i++)
+        if (name == builtins()[i].name) return i;
+    return -1;
+}
+
+// f'(a) for builtin fn, given a and v = f(a). abs uses sign(a) (0 at 0);
+// floor and ceil are treated as piecewise constant.
+inline double builtinSlope(int fn, double a, double v) {
+    switch (fn) {
+        case FN_SIN:   return cos(a);
+        case FN_COS:   return -sin(a);
+        case FN_TAN:   return 1 + v * v;
+        case FN_ASIN:  return 1 / sqrt(1 - a * a);
+        case FN_ACOS:  return -1 / sqrt(1 - a * a);
+        case FN_ATAN:  return 1 / (1 + a * a);
+        case FN_SINH:  return cosh(a);
+        case FN_COSH:  return sinh(a);
+        case FN_TANH:  return 1 - v * v;
+        case FN_EXP:   return v;
+        case FN_LN:    return 1 / a;
+        case FN_LOG:   return 0.43429448190325182765 / a;
+        case FN_SQRT:  return 0.5 / v;
+        case FN_ABS:   return a > 0 ? 1 : a < 0 ? -1 : 0;
+        default:       return 0;
+    }
+}
+
+// ============================================================================
+// ARITMETIKA INTERVAL - batas nilai f pada selang input
+// ============================================================================
+
+// Bounds are computed with round-to-nearest libm calls, not outward
+// rounding: they are meant for plotting decisions (culling, pole and
+// flatness tests), where an error of an ulp is irrelevant.
+
+// Builds a result that inherits the flags of its operands; NaN bounds
+// (e.g. inf - inf) widen to the whole line instead of poisoning tests.
+inline Interval intervalOf(double lo, double hi, const Interval& a, const Interval& b) {
+    Interval r{std::isnan(lo) ? -INFINITY : lo, std::isnan(hi) ? INFINITY : hi};
+    r.defined = a.defined && b.defined;
+    r.continuous = a.continuous && b.continuous;
+    return r;
+}
+
+inline Interval intervalOf(double lo, double hi, const Interval& a) {
+    return intervalOf(lo, hi, a, a);
+}
+
+// A sub-range where f is undefined: the domain flag drops, the bound is
+// computed on what remains.
+inline Interval intervalPartial(Interval r) {
+    r.defined = false;
+    return r;
+}
+
+// Product bound with 0 * inf taken as 0, as for a limit.
+inline double intervalMulBound(double a, double b) {
+    return a == 0 || b == 0 ? 0 : a * b;
+}
+
+inline Interval intervalAdd(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::none();
+    return intervalOf(a.lo + b.lo, a.hi + b.hi, a, b);
+}
+
+inline Interval intervalSub(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::none();
+    return intervalOf(a.lo - b.hi, a.hi - b.lo, a, b);
+}
+
+inline Interval intervalNeg(const Interval& a) {
+    if (a.empty()) return a;
+    return intervalOf(-a.hi, -a.lo, a);
+}
+
+inline Interval intervalMul(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::none();
+    double p[4] = {intervalMulBound(a.lo, b.lo), intervalMulBound(a.lo, b.hi),
+                   intervalMulBound(a.hi, b.lo), intervalMulBound(a.hi, b.hi)};
+    return intervalOf(*std::min_element(p, p + 4), *std::max_element(p, p + 4), a, b);
+}
+
+inline Interval intervalDiv(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::none();
+    if (b.contains(0)) {
+        // Pole (or 0/0) somewhere in the box: no finite bound, and the
+        // divisor's exact zero is outside the domain like in eval().
+        if (b.lo == 0 && b.hi == 0) return Interval::none();
+        Interval r = intervalOf(-INFINITY, INFINITY, a, b);
+        r.defined = false;
+        r.continuous = false;
+        return r;
+    }
+    Interval inv{1 / b.hi, 1 / b.lo, b.defined, b.continuous};
+    return intervalMul(a, inv);
+}
+
+// x^k for integer k >= 0.
+inline Interval intervalPowInt(const Interval& a, int k) {
+    if (a.empty()) return a;
+    if (k == 0) return intervalOf(1, 1, a);
+    double l = std::pow(a.lo, k), h = std::pow(a.hi, k);
+    if (k % 2) return intervalOf(l, h, a);
+    if (a.contains(0)) return intervalOf(0, std::max(l, h), a);
+    return intervalOf(std::min(l, h), std::max(l, h), a);
+}
+
+inline Interval intervalExp(const Interval& a);
+inline Interval intervalLog(const Interval& a);
+
+inline Interval intervalPow(const Interval& a, const Interval& b) {
+    if (a.empty() || b.empty()) return Interval::none();
+    // Constant integer exponent: exact, and defined for negative bases.
+    if (b.lo == b.hi && b.lo == std::floor(b.lo) && std::fabs(b.lo) < 64) {
+        int k = int(b.lo);
+        if (k >= 0) {
+            Interval r = intervalPowInt(a, k);
+            r.defined = r.defined && b.defined;
+            return r;
+        }
+        return intervalDiv(intervalOf(1, 1, b), intervalPowInt(a, -k));
+    }
+    // General case: exp(b * ln a) on the positive part of the base; a
+    // negative base gives NaN in eval(), a zero base with a negative
+    // exponent a pole.
+    Interval r = intervalExp(intervalMul(b, intervalLog(a)));
+    if (!r.empty() && a.contains(0) && b.lo < 0) {
+        r.hi = INFINITY;
+        r.continuous = false;
+    }
+    return r;
+}
+
+inline Interval intervalIncreasing(UnaryFn f, const Interval& a) {
+    if (a.empty()) return a;
+    return intervalOf(f(a.lo), f(a.hi), a);
+}
+
+// Restricts a to [lo, hi] before an increasing map; points cut away
+// leave the result partially defined.
+inline Interval intervalDomain(const Interval& a, double lo, double hi) {
+    if (a.empty() || a.hi < lo || a.lo > hi) return Interval::none();
+    Interval r = a;
+    if (a.lo < lo || a.hi > hi) {
+        r = intervalPartial(r);
+        r.lo = std::max(r.lo, lo);
+        r.hi = std::min(r.hi, hi);
+    }
+    return r;
+}
+
+inline Interval intervalExp(const Interval& a) {
+    return intervalIncreasing([](double x) { return exp(x); }, a);
+}
+
+inline Interval intervalLog(const Interval& a) {
+    return intervalIncreasing([](double x) { return log(x); }, intervalDomain(a, 0, INFINITY));
+}
+
+// sin over a, using where its maxima (pi/2 + 2k pi) and minima fall.
+inline Interval intervalSin(const Interval& a) {
+    if (a.empty()) return a;
+    const double PI = 3.14159265358979323846;
+    if (!(a.hi - a.lo < 2 * PI)) return intervalOf(-1, 1, a);
+    double l = sin(a.lo), h = sin(a.hi);
+    double lo = std::min(l, h), hi = std::max(l, h);
+    if (std::ceil((a.lo - PI / 2) / (2 * PI)) * 2 * PI + PI / 2 <= a.hi) hi = 1;
+    if (std::ceil((a.lo + PI / 2) / (2 * PI)) * 2 * PI - PI / 2 <= a.hi) lo = -1;
+    return intervalOf(lo, hi, a);
+}
+
+inline Interval intervalCall(int fn, const Interval& a) {
+    if (a.empty()) return a;
+    const double PI = 3.14159265358979323846;
+    const Builtin& f = builtins()[fn];
+    switch (fn) {
+        case FN_SIN: return intervalSin(a);
+        case FN_COS: return intervalSin(intervalAdd(a, Interval::point(PI / 2)));
+        case FN_TAN: {
+            // Poles at pi/2 + k pi
+            if (!(a.hi - a.lo < PI) || std::ceil((a.lo - PI / 2) / PI) * PI + PI / 2 <= a.hi) {
+                Interval r = intervalOf(-INFINITY, INFINITY, a);
+                r.continuous = false;
+                return r;
+            }
+            return intervalIncreasing(f.fn, a);
+        }
+        case FN_ASIN: return intervalIncreasing(f.fn, intervalDomain(a, -1, 1));
+        case FN_ACOS: return intervalNeg(intervalIncreasing([](double x) { return -acos(x); },
+                                                            intervalDomain(a, -1, 1)));
+        case FN_COSH:
+            if (a.contains(0)) return intervalOf(1, std::max(cosh(a.lo), cosh(a.hi)), a);
+            return intervalOf(std::min(cosh(a.lo), cosh(a.hi)), std::max(cosh(a.lo), cosh(a.hi)), a);
+        case FN_LN:
+        case FN_LOG:
+        case FN_SQRT: return intervalIncreasing(f.fn, intervalDomain(a, 0, INFINITY));
+        case FN_ABS:
+            if (a.contains(0)) return intervalOf(0, std::max(-a.lo, a.hi), a);
+            return intervalOf(std::min(fabs(a.lo), fabs(a.hi)), std::max(fabs(a.lo), fabs(a.hi)), a);
+        case FN_FLOOR:
+        case FN_CEIL: {
+            Interval r = intervalIncreasing(f.fn, a);
+            r.continuous = r.continuous && r.lo == r.hi;
+            return r;
+        }
+        default: return intervalIncreasing(f.fn, a);   // atan, sinh, tanh, exp
+    }
+}
+
+// Enclosure of builtinSlope over a, given v = f(a) over a.
+inline Interval intervalSlope(int fn, const Interval& a, const Interval& v) {
+    const Interval one = Interval::point(1);
+    switch (fn) {
+        case FN_SIN:   return intervalCall(FN_COS, a);
+        case FN_COS:   return intervalNeg(intervalCall(FN_SIN, a));
+        case FN_TAN:   return intervalAdd(one, intervalPowInt(v, 2));
+        case FN_ASIN:  return intervalDiv(one, intervalCall(FN_SQRT, intervalSub(one, intervalPowInt(a, 2))));
+        case FN_ACOS:  return intervalNeg(intervalSlope(FN_ASIN, a, v));
+        case FN_ATAN:  return intervalDiv(one, intervalAdd(one, intervalPowInt(a, 2)));
+        case FN_SINH:  return intervalCall(FN_COSH, a);
+        case FN_COSH:  return intervalCall(FN_SINH, a);
+        case FN_TANH:  return intervalSub(one, intervalPowInt(v, 2));
+        case FN_EXP:   return v;
+        case FN_LN:    return intervalDiv(one, a);
+        case FN_LOG:   return intervalDiv(Interval::point(0.43429448190325182765), a);
+        case FN_SQRT:  return intervalDiv(Interval::point(0.5), v);
+        case FN_ABS:   return {a.lo <= 0 ? -1.0 : 1.0, a.hi >= 0 ? 1.0 : -1.0};
+        default:       return Interval::point(0);
+    }
+}
+
+// ============================================================================
+// KERNEL BATCH - operasi per kolom untuk evalBatch
+// ============================================================================
+
+// Each kernel runs one instruction over a whole column of lanes, using the
+// SIMD kernel set picked for this CPU (see simd.hpp).
+inline void batchFill(double* __restrict d, double v, size_t n) {
+    for (size_t i = 0; i < n; i++) d[i] = v;
+}
+
+inline void batchCopy(double* __restrict d, const double* __restrict s, size_t n) {
+    for (size_t i = 0; i < n; i++) d[i] = s[i];
+}
+
+inline void batchNeg(double* d, const double* a, size_t n) {
+    for (size_t i = 0; i < n; i++) d[i] = -a[i];
+}
+
+inline void batchCall(const Builtin& f, double* d, const double* a, size_t n) {
+    if (f.column) f.column(d, a, n);
+    else for (size_t i = 0; i < n; i++) d[i] = f.fn(a[i]);
+}
+
+// Column version of builtinSlope; s must not alias a or v.
+inline void batchSlope(int fn, double* s, const double* a, const double* v, size_t n) {
+    const SimdKernels& simd = simdKernels();
+    switch (fn) {
+        case FN_SIN:  simd.cos(s, a, n); break;
+        case FN_COS:  simd.sin(s, a, n); batchNeg(s, s, n); break;
+        case FN_SINH: simd.cosh(s, a, n); break;
+        case FN_COSH: simd.sinh(s, a, n); break;
+        default:
+            for (size_t i = 0; i < n; i++) s[i] = builtinSlope(fn, a[i], v[i]);
+            break;
+    }
+}
+
+// ============================================================================
+// OPTIMASI - DAG, pelipatan konstanta dan alokasi register
+// ============================================================================
+
+// Expression DAG. Nodes are hash-consed, so identical subexpressions such
+// as sqrt(x^2 + y^2) written twice share one node. The make* constructors
+// fold and simplify as nodes are created, so a graph built bottom-up is
+// already in simplified form; emit() turns it into register code that
+// computes every shared node once.
+class ExprGraph {
+public:
+    struct Node {
+        OpCode op;
+        uint16_t arg;     // builtin id for OP_CALL
+        double value;     // OP_CONST
+        int a, b;         // children, -1 when absent
+        bool mayFail;     // subgraph contains a division that can clear ok
+    };
+
+    std::vector<Node> nodes;
+
+    bool isConst(int n) const { return nodes[n].op == OP_CONST; }
+    bool isConst(int n, double v) const { return isConst(n) && nodes[n].value == v; }
+
+    int makeConst(double v) { return intern({OP_CONST, 0, v, -1, -1, false}); }
+    int makeVar(OpCode op) { return intern({op, 0, 0, -1, -1, false}); }
+
+    int makeNeg(int a) {
+        if (isConst(a)) return makeConst(-nodes[a].value);
+        if (nodes[a].op == OP_NEG) return nodes[a].a;
+        return intern({OP_NEG, 0, 0, a, -1, nodes[a].mayFail});
+    }
+
+    int makeCall(uint16_t fn, int a) {
+        if (isConst(a)) return makeConst(builtins()[fn].fn(nodes[a].value));
+        return intern({OP_CALL, fn, 0, a, -1, nodes[a].mayFail});
+    }
+
+    int makeBinary(OpCode op, int a, int b) {
+        if (isConst(a) && isConst(b) && !(op == OP_DIV && nodes[b].value == 0)) {
+            double x = nodes[a].value, y = nodes[b].value;
+            switch (op) {
+                case OP_ADD: return makeConst(x + y);
+                case OP_SUB: return makeConst(x - y);
+                case OP_MUL: return makeConst(x * y);
+                case OP_DIV: return makeConst(x / y);
+                default:     return makeConst(pow(x, y));
+            }
+        }
+        switch (op) {
+            case OP_ADD:
+                if (isConst(a, 0)) return b;
+                if (isConst(b, 0)) return a;
+                if (a == b) return makeBinary(OP_MUL, makeConst(2), a);
+                if (nodes[b].op == OP_NEG) return makeBinary(OP_SUB, a, nodes[b].a);
+                if (nodes[a].op == OP_NEG) return makeBinary(OP_SUB, b, nodes[a].a);
+                break;
+            case OP_SUB:
+                if (isConst(b, 0)) return a;
+                if (isConst(a, 0)) return makeNeg(b);
+                if (nodes[b].op == OP_NEG) return makeBinary(OP_ADD, a, nodes[b].a);
+                break;
+            case OP_MUL:
+                if (isConst(a, 1)) return b;
+                if (isConst(b, 1)) return a;
+                if (isConst(a, -1)) return makeNeg(b);
+                if (isConst(b, -1)) return makeNeg(a);
+                if (nodes[a].op == OP_NEG && nodes[b].op == OP_NEG)
+                    return makeBinary(OP_MUL, nodes[a].a, nodes[b].a);
+                break;
+            case OP_DIV:
+                if (isConst(b, 1)) return a;
+                if (isConst(b, -1)) return makeNeg(a);
+                break;
+            default:
+                if (isConst(b, 1)) return a;
+                if (isConst(b, 0) && !nodes[a].mayFail) return makeConst(1);
+                if (isConst(b, 0.5)) return makeCall(FN_SQRT, a);
+                if (isConst(b, 2)) return makeBinary(OP_MUL, a, a);
+                if (isConst(b, 3)) return makeBinary(OP_MUL, makeBinary(OP_MUL, a, a), a);
+                break;
+        }
+        // + and * commute exactly, so x*y and y*x share a node.
+        if ((op == OP_ADD || op == OP_MUL) && a > b) std::swap(a, b);
+        return intern({op, 0, 0, a, b, nodes[a].mayFail || nodes[b].mayFail || op == OP_DIV});
+    }
+
+    // Rebuilds the graph of a compiled program; returns the root.
+    int build(const Program& prog) {
+        std::vector<int> val(prog.regCount, -1);
+        for (const Instr& in : prog.code) {
+            switch (in.op) {
+                case OP_CONST: val[in.dst] = makeConst(prog.consts[in.arg]); break;
+                case OP_X:
+                case OP_Y:     val[in.dst] = makeVar(in.op); break;
+                case OP_NEG:   val[in.dst] = makeNeg(val[in.a]); break;
+                case OP_CALL:  val[in.dst] = makeCall(in.arg, val[in.a]); break;
+                default:       val[in.dst] = makeBinary(in.op, val[in.a], val[in.b]); break;
+            }
+        }
+        return prog.empty() ? makeConst(0) : val[prog.result];
+    }
+
+    // Symbolic derivative of `root` with respect to var (OP_X or OP_Y).
+    // The result shares nodes with the original, e.g. d/dx exp(u) reuses
+    // the exp(u) node, so f and f' emitted together compute it once.
+    int derive(int root, OpCode var) {
+        std::vector<int> memo(nodes.size(), -1);
+        return deriveNode(root, var, memo);
+    }
+
+    // Emits register code for `root`. Nodes are visited children first;
+    // a node's register is released after its last consumer, and the
+    // lowest free register is reused, so regCount stays small.
+    void emit(int root, Program& prog) const {
+        prog.clear();
+        std::vector<int> uses(nodes.size(), 0), reg(nodes.size(), -1);
+        std::vector<bool> seen(nodes.size(), false), busy;
+        countUses(root, uses, seen);
+        prog.result = emitNode(root, prog, uses, reg, busy);
+    }
+
+private:
+    struct Key {
+        OpCode op;
+        uint16_t arg;
+        uint64_t bits;
+        int a, b;
+        bool operator==(const Key& o) const {
+            return op == o.op && arg == o.arg && bits == o.bits && a == o.a && b == o.b;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            uint64_t h = k.bits * 0x9E3779B97F4A7C15ULL;
+            h ^= (uint64_t(k.op) << 56) ^ (uint64_t(k.arg) << 40) ^ (uint64_t(uint32_t(k.a)) << 20) ^ uint32_t(k.b);
+            return size_t(h ^ (h >> 29));
+        }
+    };
+
+    std::unordered_map<Key, int, KeyHash> index;
+
+    // Product-rule helpers: a zero factor is exact here, because it stands
+    // for the derivative of a constant term.
+    int dMul(int a, int b) {
+        if (isConst(a, 0) || isConst(b, 0)) return makeConst(0);
+        return makeBinary(OP_MUL, a, b);
+    }
+
+    int dDiv(int a, int b) {
+        if (isConst(a, 0)) return makeConst(0);
+        return makeBinary(OP_DIV, a, b);
+    }
+
+    int deriveNode(int n, OpCode var, std::vector<int>& memo) {
+        if (memo[n] >= 0) return memo[n];
+        Node nd = nodes[n];
+        int a = nd.a, b = nd.b, r;
+        int da = a >= 0 ? deriveNode(a, var, memo) : -1;
+        int db = b >= 0 && nd.op != OP_CALL && nd.op != OP_NEG ? deriveNode(b, var, memo) : -1;
+
+        switch (nd.op) {
+            case OP_CONST: r = makeConst(0); break;
+            case OP_X:
+            case OP_Y:     r = makeConst(nd.op == var ? 1 : 0); break;
+            case OP_ADD:   r = makeBinary(OP_ADD, da, db); break;
+            case OP_SUB:   r = makeBinary(OP_SUB, da, db); break;
+            case OP_NEG:   r = makeNeg(da); break;
+            case OP_MUL:   r = makeBinary(OP_ADD, dMul(da, b), dMul(a, db)); break;
+            case OP_DIV:
+                // (a/b)' = a'/b - a*b'/b^2
+                r = makeBinary(OP_SUB, dDiv(da, b), dDiv(dMul(a, db), makeBinary(OP_MUL, b, b)));
+                break;
+            case OP_POW:
+                if (isConst(b)) {
+                    // (a^c)' = c * a^(c-1) * a'
+                    double c = nodes[b].value;
+                    r = dMul(dMul(makeConst(c), makeBinary(OP_POW, a, makeConst(c - 1))), da);
+                } else {
+                    // (a^b)' = a^b * (b' ln a + b a'/a)
+                    int t1 = dMul(db, makeCall(FN_LN, a));
+                    int t2 = dDiv(dMul(b, da), a);
+                    r = dMul(n, makeBinary(OP_ADD, t1, t2));
+                }
+                break;
+            default:
+                r = dMul(builtinDerivative(n, nd.arg, a), da);
+                break;
+        }
+        return memo[n] = r;
+    }
+
+    // f'(a) for builtin f; n is the node f(a) itself.
+    int builtinDerivative(int n, int fn, int a) {
+        switch (fn) {
+            case FN_SIN:  return makeCall(FN_COS, a);
+            case FN_COS:  return makeNeg(makeCall(FN_SIN, a));
+            case FN_TAN:  return makeBinary(OP_ADD, makeConst(1), makeBinary(OP_MUL, n, n));
+            case FN_ASIN:
+                return makeBinary(OP_DIV, makeConst(1),
+                                  makeCall(FN_SQRT, makeBinary(OP_SUB, makeConst(1), makeBinary(OP_MUL, a, a))));
+            case FN_ACOS:
+                return makeBinary(OP_DIV, makeConst(-1),
+                                  makeCall(FN_SQRT, makeBinary(OP_SUB, makeConst(1), makeBinary(OP_MUL, a, a))));
+            case FN_ATAN:
+                return makeBinary(OP_DIV, makeConst(1), makeBinary(OP_ADD, makeConst(1), makeBinary(OP_MUL, a, a)));
+            case FN_SINH: return makeCall(FN_COSH, a);
+            case FN_COSH: return makeCall(FN_SINH, a);
+            case FN_TANH: return makeBinary(OP_SUB, makeConst(1), makeBinary(OP_MUL, n, n));
+            case FN_EXP:  return n;
+            case FN_LN:   return makeBinary(OP_DIV, makeConst(1), a);
+            case FN_LOG:  return makeBinary(OP_DIV, makeConst(0.43429448190325182765), a);
+            case FN_SQRT: return makeBinary(OP_DIV, makeConst(0.5), n);
+            case FN_ABS:  return makeBinary(OP_DIV, a, n);
+            default:      return makeConst(0);   // floor, ceil: piecewise constant
+        }
+    }
+
+    int intern(const Node& n) {
+        Key key = {n.op, n.arg, 0, n.a, n.b};
+        memcpy(&key.bits, &n.value, sizeof(double));
+        auto it = index.find(key);
+        if (it != index.end()) return it->second;
+        nodes.push_back(n);
+        return index[key] = int(nodes.size()) - 1;
+    }
+
+    void countUses(int n, std::vector<int>& uses, std::vector<bool>& seen) const {
+        if (seen[n]) return;
+        seen[n] = true;
+        const Node& nd = nodes[n];
+        if (nd.a >= 0) { uses[nd.a]++; countUses(nd.a, uses, seen); }
+        if (nd.b >= 0) { uses[nd.b]++; countUses(nd.b, uses, seen); }
+    }
+
+    int emitNode(int n, Program& prog, std::vector<int>& uses, std::vector<int>& reg,
+                 std::vector<bool>& busy) const {
+        if (reg[n] >= 0) return reg[n];
+        const Node& nd = nodes[n];
+        int ra = nd.a >= 0 ? emitNode(nd.a, prog, uses, reg, busy) : 0;
+        int rb = nd.b >= 0 ? emitNode(nd.b, prog, uses, reg, busy) : 0;
+        if (nd.a >= 0 && --uses[nd.a] == 0) busy[ra] = false;
+        if (nd.b >= 0 && --uses[nd.b] == 0) busy[rb] = false;
+
+        int r = 0;
+        while (r < int(busy.size()) && busy[r]) r++;
+        if (r == int(busy.size())) busy.push_back(true);
+        busy[r] = true;
+        reg[n] = r;
+        prog.regCount = std::max(prog.regCount, r + 1);
+
+        uint16_t arg = nd.arg;
+        if (nd.op == OP_CONST) {
+            arg = uint16_t(prog.consts.size());
+            prog.consts.push_back(nd.value);
+        }
+        if (nd.op == OP_Y) prog.usesY = true;
+        prog.code.push_back({nd.op, uint8_t(r), uint8_t(ra), uint8_t(rb), arg});
+        return r;
+    }
+};
+
+// ============================================================================
+// PARSER - Parsing, Kompilasi dan Evaluasi Ekspresi
+// ============================================================================
+
+class Parser {
+public:
+    static const int MAX_REGS = 64;
+    static const size_t BATCH = 256;
+
+    std::vector<Token> parse(const std::string& s, std::string& err) const {
+        std::vector<Token> toks;
+        err.clear();
+
+        for (size_t i = 0; i < s.size();) {
+            char c = s[i];
+
+            if (isspace((unsigned char)c)) { i++; continue; }
+
+            if (isdigit((unsigned char)c) || c == '.') {
+                size_t j = i;
+                bool hasDot = false, hasE = false;
+                while (j < s.size()) {
+                    char d = s[j];
+                    if (isdigit((unsigned char)d)) j++;
+                    else if (d == '.' && !hasDot && !hasE) { hasDot = true; j++; }
+                    else if ((d == 'e' || d == 'E') && !hasE && j + 1 < s.size() &&
+                             (isdigit((unsigned char)s[j+1]) ||
+                              ((s[j+1] == '+' || s[j+1] == '-') && j + 2 < s.size() && isdigit((unsigned char)s[j+2])))) {
+                        hasE = true;
+                        j += 2;
+                    }
+                    else break;
+                }
+                toks.push_back({Token::NUMBER, strtod(s.c_str() + i, 0)});
+                i = j;
+                continue;
+            }
+
+            // Identifiers may contain '_' and are case-insensitive, so "X"
+            // is the variable x and "SIN" is sin.
+            if (isalpha((unsigned char)c) || c == '_') {
+                size_t j = i;
+                while (j < s.size() && (isalnum((unsigned char)s[j]) || s[j] == '_')) j++;
+                std::string id = s.substr(i, j - i);
+                for (char& ch : id) ch = char(tolower((unsigned char)ch));
+
+                if (id == "x") toks.push_back({Token::VAR_X});
+                else if (id == "y") toks.push_back({Token::VAR_Y});
+                else if (id == "pi") toks.push_back({Token::NUMBER, 3.14159265358979});
+                else if (id == "e") toks.push_back({Token::NUMBER, 2.71828182845905});
+                else toks.push_back({Token::FUNC, 0, id});
+
+                i = j;
+                continue;
+            }
+
+            if (c == '(') { toks.push_back({Token::LPAREN}); i++; continue; }
+            if (c == ')') { toks.push_back({Token::RPAREN}); i++; continue; }
+
+            if (std::string("+-*/^").find(c) != std::string::npos) {
+                int p = (c == '+' || c == '-') ? 1 : (c == '*' || c == '/') ? 2 : 3;
+                toks.push_back({Token::OP, 0, std::string(1, c), p, c == '^'});
+                i++;
+                continue;
+            }
+
+            err = "Karakter tidak dikenal: '" + std::string(1, c) + "'";
+            return {};
+        }
+
+        std::vector<Token> out;
+        for (size_t i = 0; i < toks.size(); i++) {
+            if (toks[i].type == Token::OP && toks[i].text == "-" &&
+                (i == 0 || toks[i-1].type == Token::OP || toks[i-1].type == Token::LPAREN))
+                out.push_back({Token::NUMBER, 0});
+            out.push_back(toks[i]);
+        }
+        return out;
+    }
+
+    // Shunting-yard, lalu token RPN diterjemahkan ke DAG dan kode register.
+    Program toRPN(const std::vector<Token>& toks, std::string& err) const {
+        std::vector<Token> out, st;
+        err.clear();
+
+        for (auto& t : toks) {
+            if (t.type == Token::NUMBER || t.type == Token::VAR_X || t.type == Token::VAR_Y)
+                out.push_back(t);
+            else if (t.type == Token::FUNC)
+                st.push_back(t);
+            else if (t.type == Token::OP) {
+                while (!st.empty() && st.back().type == Token::OP &&
+                       ((!t.rightAssoc && t.precedence <= st.back().precedence) ||
+                        (t.rightAssoc && t.precedence < st.back().precedence))) {
+                    out.push_back(st.back());
+                    st.pop_back();
+                }
+                st.push_back(t);
+            } else if (t.type == Token::LPAREN)
+                st.push_back(t);
+            else if (t.type == Token::RPAREN) {
+                while (!st.empty() && st.back().type != Token::LPAREN) {
+                    out.push_back(st.back());
+                    st.pop_back();
+                }
+                if (st.empty()) { err = "Kurung tidak seimbang"; return {}; }
+                st.pop_back();
+                if (!st.empty() && st.back().type == Token::FUNC) {
+                    out.push_back(st.back());
+                    st.pop_back();
+                }
+            }
+        }
+
+        while (!st.empty()) {
+            if (st.back().type == Token::LPAREN) {
+                err = "Kurung tidak seimbang";
+                return {};
+            }
+            out.push_back(st.back());
+            st.pop_back();
+        }
+        return assemble(out, err);
+    }
+
+    bool compile(const std::string& expr, Program& prog, std::string& err) const {
+        auto toks = parse(expr, err);
+        if (!err.empty()) { prog.clear(); return false; }
+        prog = toRPN(toks, err);
+        return err.empty();
+    }
+
+    double eval(const Program& prog, double x, bool& ok) const {
+        return eval(prog, x, 0, ok);
+    }
+
+    double eval(const Program& prog, double x, double y, bool& ok) const {
+        ok = true;
+        if (prog.empty()) return 0;
+        double r[MAX_REGS];
+        const double* k = prog.consts.data();
+        const Builtin* fns = builtins();
+
+        for (const Instr& in : prog.code) {
+            switch (in.op) {
+                case OP_CONST: r[in.dst] = k[in.arg]; break;
+                case OP_X:     r[in.dst] = x; break;
+                case OP_Y:     r[in.dst] = y; break;
+                case OP_ADD:   r[in.dst] = r[in.a] + r[in.b]; break;
+                case OP_SUB:   r[in.dst] = r[in.a] - r[in.b]; break;
+                case OP_MUL:   r[in.dst] = r[in.a] * r[in.b]; break;
+                case OP_DIV:
+                    if (r[in.b] != 0) r[in.dst] = r[in.a] / r[in.b];
+                    else { ok = false; r[in.dst] = 0; }
+                    break;
+                case OP_POW:   r[in.dst] = pow(r[in.a], r[in.b]); break;
+                case OP_CALL:  r[in.dst] = fns[in.arg].fn(r[in.a]); break;
+                case OP_NEG:   r[in.dst] = -r[in.a]; break;
+            }
+        }
+        return r[prog.result];
+    }
+
+    // Evaluates the program once per instruction over whole columns of
+    // samples. okMask[i] is 0 where the scalar eval() would report !ok.
+    void evalBatch(const Program& prog, const double* xs, double* ys, uint8_t* okMask, size_t n) const {
+        evalBatch(prog, xs, nullptr, ys, okMask, n);
+    }
+
+    // Two-variable variant; ys may be null when the program does not use y.
+    // Each register is a column of BATCH lanes.
+    void evalBatch(const Program& prog, const double* xs, const double* ys, double* out,
+                   uint8_t* okMask, size_t n) const {
+        static thread_local std::vector<double> regs;
+        if (regs.size() < prog.regCount * BATCH) regs.resize(prog.regCount * BATCH);
+        const double* k = prog.consts.data();
+        const Builtin* fns = builtins();
+        const SimdKernels& simd = simdKernels();
+
+        for (size_t base = 0; base < n; base += BATCH) {
+            size_t m = std::min(BATCH, n - base);
+            uint8_t* ok = okMask + base;
+            for (size_t i = 0; i < m; i++) ok[i] = 1;
+            if (prog.empty()) {
+                batchFill(out + base, 0, m);
+                continue;
+            }
+
+            // col[r] is where register r currently lives: its own column,
+            // or the caller's x/y array, which is read but never copied.
+            double* R = regs.data();
+            const double* col[MAX_REGS] = {};
+            for (const Instr& in : prog.code) {
+                double* d = R + in.dst * BATCH;
+                const double* a = col[in.a];
+                const double* b = col[in.b];
+                switch (in.op) {
+                    case OP_CONST: batchFill(d, k[in.arg], m); break;
+                    case OP_X:     col[in.dst] = xs + base; continue;
+                    case OP_Y:
+                        if (ys) { col[in.dst] = ys + base; continue; }
+                        batchFill(d, 0, m);
+                        break;
+                    case OP_ADD:   simd.add(d, a, b, m); break;
+                    case OP_SUB:   simd.sub(d, a, b, m); break;
+                    case OP_MUL:   simd.mul(d, a, b, m); break;
+                    case OP_DIV:   simd.div(d, a, b, ok, m); break;
+                    case OP_POW:   simd.pow(d, a, b, m); break;
+                    case OP_CALL:  batchCall(fns[in.arg], d, a, m); break;
+                    case OP_NEG:   batchNeg(d, a, m); break;
+                }
+                col[in.dst] = d;
+            }
+            batchCopy(out + base, col[prog.result], m);
+        }
+    }
+
+    // Forward-mode AD: f(x) and f'(x) in one pass over the program, for
+    // expressions whose symbolic derivative grows too large.
+    Dual evalDual(const Program& prog, double x, bool& ok) const {
+        const double sx[1] = {1}, sy[1] = {0};
+        double d[1];
+        double v = evalTangent<1>(prog, x, 0, sx, sy, d, ok);
+        return {v, d[0]};
+    }
+
+    // f(x, y) with its exact gradient, e.g. for surface normals.
+    Grad evalGrad(const Program& prog, double x, double y, bool& ok) const {
+        const double sx[2] = {1, 0}, sy[2] = {0, 1};
+        double d[2];
+        double v = evalTangent<2>(prog, x, y, sx, sy, d, ok);
+        return {v, d[0], d[1]};
+    }
+
+    void evalDualBatch(const Program& prog, const double* xs, double* ys, double* dys,
+                       uint8_t* okMask, size_t n) const {
+        const double sx[1] = {1}, sy[1] = {0};
+        double* ders[1] = {dys};
+        evalTangentBatch<1>(prog, xs, nullptr, sx, sy, ys, ders, okMask, n);
+    }
+
+    void evalGradBatch(const Program& prog, const double* xs, const double* ys, double* out,
+                       double* dx, double* dy, uint8_t* okMask, size_t n) const {
+        const double sx[2] = {1, 0}, sy[2] = {0, 1};
+        double* ders[2] = {dx, dy};
+        evalTangentBatch<2>(prog, xs, ys, sx, sy, out, ders, okMask, n);
+    }
+
+    // Interval evaluation: bounds f over the box x * y, with flags telling
+    // whether f may be undefined or discontinuous there.
+    Interval evalInterval(const Program& prog, Interval x, Interval y = Interval::point(0)) const {
+        return evalIntervalSlope(prog, x, y, nullptr);
+    }
+
+    // Also bounds df/dx over the box (only meaningful where the value is
+    // defined and continuous), e.g. to prove a stretch flat or monotone.
+    Interval evalIntervalSlope(const Program& prog, Interval x, Interval y, Interval* slope) const {
+        if (slope) *slope = Interval::point(0);
+        if (prog.empty()) return Interval::point(0);
+        Interval r[MAX_REGS], t[MAX_REGS];
+        const double* c = prog.consts.data();
+        const Interval zero = Interval::point(0);
+
+        for (const Instr& in : prog.code) {
+            const Interval& va = r[in.a];
+            const Interval& vb = r[in.b];
+            const Interval& ta = t[in.a];
+            const Interval& tb = t[in.b];
+            Interval v = zero, td = zero;
+            switch (in.op) {
+                case OP_CONST: v = Interval::point(c[in.arg]); break;
+                case OP_X:     v = x; td = Interval::point(1); break;
+                case OP_Y:     v = y; break;
+                case OP_ADD:
+                    v = intervalAdd(va, vb);
+                    if (slope) td = intervalAdd(ta, tb);
+                    break;
+                case OP_SUB:
+                    v = intervalSub(va, vb);
+                    if (slope) td = intervalSub(ta, tb);
+                    break;
+                case OP_MUL:
+                    // x^2 is emitted as x*x; a square never goes negative,
+                    // which intervalMul cannot know for two operands.
+                    if (in.a == in.b) {
+                        v = intervalPowInt(va, 2);
+                        if (slope) td = intervalMul(intervalMul(Interval::point(2), va), ta);
+                        break;
+                    }
+                    v = intervalMul(va, vb);
+                    if (slope) td = intervalAdd(intervalMul(ta, vb), intervalMul(va, tb));
+                    break;
+                case OP_DIV:
+                    v = intervalDiv(va, vb);
+                    if (slope) td = intervalDiv(intervalSub(ta, intervalMul(v, tb)), vb);
+                    break;
+                case OP_POW:
+                    v = intervalPow(va, vb);
+                    if (slope) {
+                        // b * a^(b-1) * a' + a^b * ln(a) * b'
+                        if (ta.lo != 0 || ta.hi != 0)
+                            td = intervalMul(intervalMul(vb, intervalPow(va, intervalSub(vb, Interval::point(1)))), ta);
+                        if (tb.lo != 0 || tb.hi != 0)
+                            td = intervalAdd(td, intervalMul(intervalMul(v, intervalLog(va)), tb));
+                    }
+                    break;
+                case OP_CALL:
+                    v = intervalCall(in.arg, va);
+                    if (slope) td = intervalMul(intervalSlope(in.arg, va, v), ta);
+                    break;
+                case OP_NEG:
+                    v = intervalNeg(va);
+                    if (slope) td = intervalNeg(ta);
+                    break;
+            }
+            r[in.dst] = v;
+            t[in.dst] = td;
+        }
+        if (slope) *slope = t[prog.result];
+        return r[prog.result];
+    }
+
+    // Compiles the order-th derivative of prog with respect to var (OP_X or
+    // OP_Y) into a new program. The derivative is taken symbolically on the
+    // expression DAG, so it is simplified and CSE'd like any other program
+    // and costs one evaluation per sample.
+    bool differentiate(const Program& prog, Program& out, std::string& err,
+                       int order = 1, OpCode var = OP_X) const {
+        err.clear();
+        ExprGraph g;
+        int root = g.build(prog);
+        for (int i = 0; i < order; i++) root = g.derive(root, var);
+        g.emit(root, out);
+        if (out.regCount > MAX_REGS) {
+            err = "Ekspresi terlalu kompleks";
+            out.clear();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // Dual numbers with N tangent components: x and y carry the seed
+    // tangents sx and sy, every instruction propagates value and tangents.
+    // Division by zero behaves as in eval(), with zero tangents.
+    template <int N>
+    double evalTangent(const Program& prog, double x, double y, const double (&sx)[N],
+                       const double (&sy)[N], double (&der)[N], bool& ok) const {
+        ok = true;
+        for (int k = 0; k < N; k++) der[k] = 0;
+        if (prog.empty()) return 0;
+        double r[MAX_REGS], t[MAX_REGS][N];
+        const double* c = prog.consts.data();
+        const Builtin* fns = builtins();
+
+        for (const Instr& in : prog.code) {
+            // Operands are only read by the cases that use them; td is
+            // separate so dst may alias a or b.
+            const double& va = r[in.a];
+            const double& vb = r[in.b];
+            const double* ta = t[in.a];
+            const double* tb = t[in.b];
+            double v = 0, td[N] = {};
+            switch (in.op) {
+                case OP_CONST:
+                    v = c[in.arg];
+                    for (int k = 0; k < N; k++) td[k] = 0;
+                    break;
+                case OP_X:
+                case OP_Y:
+                    v = in.op == OP_X ? x : y;
+                    for (int k = 0; k < N; k++) td[k] = in.op == OP_X ? sx[k] : sy[k];
+                    break;
+                case OP_ADD:
+                    v = va + vb;
+                    for (int k = 0; k < N; k++) td[k] = ta[k] + tb[k];
+                    break;
+                case OP_SUB:
+                    v = va - vb;
+                    for (int k = 0; k < N; k++) td[k] = ta[k] - tb[k];
+                    break;
+                case OP_MUL:
+                    v = va * vb;
+                    for (int k = 0; k < N; k++) td[k] = ta[k] * vb + va * tb[k];
+                    break;
+                case OP_DIV:
+                    if (vb == 0) {
+                        ok = false;
+                        for (int k = 0; k < N; k++) td[k] = 0;
+                        break;
+                    }
+                    v = va / vb;
+                    for (int k = 0; k < N; k++) td[k] = (ta[k] - v * tb[k]) / vb;
+                    break;
+                case OP_POW: {
+                    v = pow(va, vb);
+                    bool da = false, db = false;
+                    for (int k = 0; k < N; k++) { da |= ta[k] != 0; db |= tb[k] != 0; }
+                    double pa = da ? vb * pow(va, vb - 1) : 0;
+                    double pb = db ? v * log(va) : 0;
+                    for (int k = 0; k < N; k++) td[k] = (da ? pa * ta[k] : 0) + (db ? pb * tb[k] : 0);
+                    break;
+                }
+                case OP_CALL: {
+                    v = fns[in.arg].fn(va);
+                    double s = builtinSlope(in.arg, va, v);
+                    for (int k = 0; k < N; k++) td[k] = s * ta[k];
+                    break;
+                }
+                case OP_NEG:
+                    v = -va;
+                    for (int k = 0; k < N; k++) td[k] = -ta[k];
+                    break;
+            }
+            r[in.dst] = v;
+            for (int k = 0; k < N; k++) t[in.dst][k] = td[k];
+        }
+        for (int k = 0; k < N; k++) der[k] = t[prog.result][k];
+        return r[prog.result];
+    }
+
+    // Column version of evalTangent. Each register has a value column and
+    // N tangent columns; registers whose tangent is known to be zero (built
+    // from constants only) skip the tangent arithmetic entirely.
+    template <int N>
+    void evalTangentBatch(const Program& prog, const double* xs, const double* ys,
+                          const double (&sx)[N], const double (&sy)[N], double* out,
+                          double* const (&ders)[N], uint8_t* okMask, size_t n) const {
+        const size_t stride = (N + 1) * BATCH;
+        static thread_local std::vector<double> regs;
+        if (regs.size() < prog.regCount * stride + 2 * BATCH) regs.resize(prog.regCount * stride + 2 * BATCH);
+        const double* c = prog.consts.data();
+        const Builtin* fns = builtins();
+        const SimdKernels& simd = simdKernels();
+        double* s1 = regs.data() + prog.regCount * stride;
+        double* s2 = s1 + BATCH;
+
+        for (size_t base = 0; base < n; base += BATCH) {
+            size_t m = std::min(BATCH, n - base);
+            uint8_t* ok = okMask + base;
+            for (size_t i = 0; i < m; i++) ok[i] = 1;
+            if (prog.empty()) {
+                batchFill(out + base, 0, m);
+                for (int k = 0; k < N; k++) batchFill(ders[k] + base, 0, m);
+                continue;
+            }
+
+            bool zero[MAX_REGS] = {};
+            for (const Instr& in : prog.code) {
+                double* v = regs.data() + in.dst * stride;
+                const double* va = regs.data() + in.a * stride;
+                const double* vb = regs.data() + in.b * stride;
+                auto T = [&](double* col, int k) { return col + (k + 1) * BATCH; };
+                auto cT = [&](const double* col, int k) { return col + (k + 1) * BATCH; };
+                bool za = zero[in.a], zb = zero[in.b];
+
+                switch (in.op) {
+                    case OP_CONST:
+                        batchFill(v, c[in.arg], m);
+                        zero[in.dst] = true;
+                        break;
+                    case OP_X:
+                    case OP_Y: {
+                        const double* src = in.op == OP_X ? xs : ys;
+                        if (src) batchCopy(v, src + base, m);
+                        else batchFill(v, 0, m);
+                        const double* seed = in.op == OP_X ? sx : sy;
+                        zero[in.dst] = true;
+                        for (int k = 0; k < N; k++) {
+                            batchFill(T(v, k), seed[k], m);
+                            if (seed[k] != 0) zero[in.dst] = false;
+                        }
+                        break;
+                    }
+                    case OP_ADD:
+                    case OP_SUB:
+                        for (int k = 0; k < N && !(za && zb); k++) {
+                            double* d = T(v, k);
+                            if (za) batchFill(s1, 0, m);
+                            if (zb) batchFill(s2, 0, m);
+                            const double* ta = za ? s1 : cT(va, k);
+                            const double* tb = zb ? s2 : cT(vb, k);
+                            if (in.op == OP_ADD) simd.add(d, ta, tb, m);
+                            else simd.sub(d, ta, tb, m);
+                        }
+                        if (in.op == OP_ADD) simd.add(v, va, vb, m);
+                        else simd.sub(v, va, vb, m);
+                        zero[in.dst] = za && zb;
+                        break;
+                    case OP_MUL:
+                        // d(ab) = a'b + ab'; the value column is written last
+                        // because dst may alias a or b.
+                        for (int k = 0; k < N && !(za && zb); k++) {
+                            double* d = T(v, k);
+                            const double* ta = cT(va, k);
+                            const double* tb = cT(vb, k);
+                            for (size_t i = 0; i < m; i++)
+                                d[i] = (za ? 0 : ta[i] * vb[i]) + (zb ? 0 : va[i] * tb[i]);
+                        }
+                        simd.mul(v, va, vb, m);
+                        zero[in.dst] = za && zb;
+                        break;
+                    case OP_DIV:
+                        simd.div(s1, va, vb, ok, m);
+                        for (int k = 0; k < N && !(za && zb); k++) {
+                            double* d = T(v, k);
+                            const double* ta = cT(va, k);
+                            const double* tb = cT(vb, k);
+                            for (size_t i = 0; i < m; i++) {
+                                double num = (za ? 0 : ta[i]) - (zb ? 0 : s1[i] * tb[i]);
+                                d[i] = vb[i] != 0 ? num / vb[i] : 0;
+                            }
+                        }
+                        batchCopy(v, s1, m);
+                        zero[in.dst] = za && zb;
+                        break;
+                    case OP_POW:
+                        simd.pow(s1, va, vb, m);
+                        if (!za) {
+                            // s2 = b * a^(b-1)
+                            for (size_t i = 0; i < m; i++) s2[i] = vb[i] - 1;
+                            simd.pow(s2, va, s2, m);
+                            simd.mul(s2, s2, vb, m);
+                        }
+                        for (int k = 0; k < N && !(za && zb); k++) {
+                            double* d = T(v, k);
+                            const double* ta = cT(va, k);
+                            const double* tb = cT(vb, k);
+                            for (size_t i = 0; i < m; i++)
+                                d[i] = (za ? 0 : s2[i] * ta[i]) + (zb ? 0 : s1[i] * log(va[i]) * tb[i]);
+                        }
+                        batchCopy(v, s1, m);
+                        zero[in.dst] = za && zb;
+                        break;
+                    case OP_CALL:
+                        batchCall(fns[in.arg], s1, va, m);
+                        if (!za) {
+                            batchSlope(in.arg, s2, va, s1, m);
+                            for (int k = 0; k < N; k++) simd.mul(T(v, k), s2, cT(va, k), m);
+                        }
+                        batchCopy(v, s1, m);
+                        zero[in.dst] = za;
+                        break;
+                    case OP_NEG:
+                        if (!za)
+                            for (int k = 0; k < N; k++) batchNeg(T(v, k), cT(va, k), m);
+                        batchNeg(v, va, m);
+                        zero[in.dst] = za;
+                        break;
+                }
+            }
+
+            const double* res = regs.data() + prog.result * stride;
+            batchCopy(out + base, res, m);
+            for (int k = 0; k < N; k++) {
+                if (zero[prog.result]) batchFill(ders[k] + base, 0, m);
+                else batchCopy(ders[k] + base, res + (k + 1) * BATCH, m);
+            }
+        }
+    }
+
+    // Builds the DAG from RPN, checking operand counts once, then
+    // allocates registers; eval() needs no bounds checks afterwards.
+    Program assemble(const std::vector<Token>& rpn, std::string& err) const {
+        Program prog;
+        if (rpn.empty()) return prog;
+
+        ExprGraph g;
+        std::vector<int> st;
+        for (auto& t : rpn) {
+            if (t.type == Token::NUMBER)
+                st.push_back(g.makeConst(t.value));
+            else if (t.type == Token::VAR_X)
+                st.push_back(g.makeVar(OP_X));
+            else if (t.type == Token::VAR_Y)
+                st.push_back(g.makeVar(OP_Y));
+            else if (t.type == Token::OP) {
+                if (st.size() < 2) { err = "Ekspresi tidak valid"; return {}; }
+                OpCode op = t.text == "+" ? OP_ADD : t.text == "-" ? OP_SUB :
+                            t.text == "*" ? OP_MUL : t.text == "/" ? OP_DIV : OP_POW;
+                int b = st.back();
+                st.pop_back();
+                st.back() = g.makeBinary(op, st.back(), b);
+            } else if (t.type == Token::FUNC) {
+                int id = findBuiltin(t.text);
+                if (id < 0) { err = "Fungsi tidak dikenal: " + t.text; return {}; }
+                if (st.empty()) { err = "Ekspresi tidak valid"; return {}; }
+                st.back() = g.makeCall(uint16_t(id), st.back());
+            }
+        }
+
+        if (st.size() != 1) { err = "Ekspresi tidak valid"; return {}; }
+        g.emit(st.back(), prog);
+        if (prog.regCount > MAX_REGS) { err = "Ekspresi terlalu kompleks"; return {}; }
+        return prog;
+    }
+};
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// THREAD POOL - antrian per worker dengan work stealing
+// ============================================================================
+
+// Created once at startup. Every worker owns a deque: it pops its own work
+// from the back and, when that runs dry, steals from the front of the
+// others. Tasks submitted from outside go round-robin over the deques. A
+// thread waiting in parallelFor() runs queued tasks itself, so nested
+// parallelFor calls from inside a task cannot deadlock.
+class ThreadPool {
+public:
+    // threads == 0 uses one worker per hardware thread, minus the caller.
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) {
+            unsigned hw = std::thread::hardware_concurrency();
+            threads = hw > 1 ? hw - 1 : 1;
+        }
+        for (unsigned i = 0; i < threads; i++) queues.emplace_back(new Queue);
+        for (unsigned i = 0; i < threads; i++) workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return unsigned(workers.size()); }
+
+    // Queues a task without waiting for it.
+    void submit(std::function<void()> task) {
+        size_t q = next.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[q]->m);
+            queues[q]->tasks.push_back(std::move(task));
+        }
+        pending.fetch_add(1, std::memory_order_release);
+        {
+            // Pairs with the predicate check in workerLoop so a worker
+            // about to sleep cannot miss this task.
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    // Runs body(begin, end) over [0, n) in chunks of at most grain items,
+    // spread over the workers and the calling thread. Returns when every
+    // chunk has finished.
+    template <typename F>
+    void parallelFor(size_t n, size_t grain, F body) {
+        if (n == 0) return;
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (n + grain - 1) / grain;
+        if (chunks == 1) {
+            body(size_t(0), n);
+            return;
+        }
+        std::atomic<size_t> remaining(chunks);
+        for (size_t c = 1; c < chunks; c++) {
+            size_t b = c * grain, e = std::min(n, b + grain);
+            submit([&, b, e] {
+                body(b, e);
+                remaining.fetch_sub(1, std::memory_order_acq_rel);
+            });
+        }
+        body(size_t(0), std::min(n, grain));
+        remaining.fetch_sub(1, std::memory_order_acq_rel);
+        while (remaining.load(std::memory_order_acquire) != 0)
+            if (!runOne(next.load(std::memory_order_relaxed) % queues.size(), false)) std::this_thread::yield();
+    }
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Runs one task: the back of queue `self` (LIFO, cache-warm) if own is
+    // set, otherwise the front of the first non-empty queue from self on.
+    bool runOne(size_t self, bool own) {
+        std::function<void()> task;
+        size_t n = queues.size();
+        for (size_t k = 0; k < n && !task; k++) {
+            Queue& q = *queues[(self + k) % n];
+            std::lock_guard<std::mutex> lock(q.m);
+            if (q.tasks.empty()) continue;
+            if (own && k == 0) {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            } else {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+        }
+        if (!task) return false;
+        pending.fetch_sub(1, std::memory_order_relaxed);
+        task();
+        return true;
+    }
+
+    void workerLoop(size_t id) {
+        for (;;) {
+            if (runOne(id, true)) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stop || pending.load(std::memory_order_acquire) > 0; });
+            if (stop) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> pending{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stop = false;
+};
+
+// ============================================================================
+// JOB TERBARU - satu job latar belakang, permintaan lama dibatalkan
+// ============================================================================
+
+// Runs background jobs on a ThreadPool one at a time, for work where only
+// the newest request matters (e.g. geometry for the current view). Posting
+// while a job runs raises that job's cancel flag and parks the new one in
+// its place; a job that was parked and then replaced never runs. Jobs poll
+// the flag and return early, so the next one starts after at most one
+// checkpoint's worth of stale work.
+class LatestJob {
+public:
+    typedef std::function<void(const std::atomic<bool>& cancelled)> Job;
+
+    explicit LatestJob(ThreadPool& pool) : pool(pool) {}
+
+    // Cancels the running job and waits for it; parked jobs are dropped.
+    ~LatestJob() {
+        std::unique_lock<std::mutex> lock(m);
+        parked = nullptr;
+        if (cancel) cancel->store(true);
+        idle.wait(lock, [this] { return !running; });
+    }
+
+    LatestJob(const LatestJob&) = delete;
+    LatestJob& operator=(const LatestJob&) = delete;
+
+    void post(Job job) {
+        std::lock_guard<std::mutex> lock(m);
+        if (running) {
+            cancel->store(true);
+            parked = std::move(job);
+        } else {
+            start(std::move(job));
+        }
+    }
+
+    bool busy() const {
+        std::lock_guard<std::mutex> lock(m);
+        return running;
+    }
+
+private:
+    // Called with m held.
+    void start(Job job) {
+        running = true;
+        cancel = std::make_shared<std::atomic<bool>>(false);
+        std::shared_ptr<std::atomic<bool>> flag = cancel;
+        pool.submit([this, flag, job] {
+            job(*flag);
+            std::lock_guard<std::mutex> lock(m);
+            running = false;
+            if (parked) {
+                Job next = std::move(parked);
+                parked = nullptr;
+                start(std::move(next));
+            } else {
+                idle.notify_all();
+            }
+        });
+    }
+
+    ThreadPool& pool;
+    mutable std::mutex m;
+    std::condition_variable idle;
+    bool running = false;
+    Job parked;
+    std::shared_ptr<std::atomic<bool>> cancel;
+};
+
+// Hand-over slot for the newest finished result: the producer overwrites,
+// the consumer takes it at most once.
+template <typename T>
+class LatestResult {
+public:
+    void put(T v) {
+        std::lock_guard<std::mutex> lock(m);
+        value = std::move(v);
+        fresh = true;
+    }
+
+    bool take(T& out) {
+        std::lock_guard<std::mutex> lock(m);
+        if (!fresh) return false;
+        out = std::move(value);
+        fresh = false;
+        return true;
+    }
+
+private:
+    std::mutex m;
+    T value;
+    bool fresh = false;
+};
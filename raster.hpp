@@ -0,0 +1,496 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pool.hpp"
+
+// ============================================================================
+// RASTER - gambar RGB di CPU dan penulis PPM/PNG
+// ============================================================================
+
+struct Rgb {
+    uint8_t r, g, b;
+};
+
+// A point in pixel coordinates.
+struct PathPoint {
+    double x, y;
+};
+
+// 8-bit RGB image in memory, for rendering without a window or a GL
+// context. Pixel (x, y) has y growing downwards; writes outside the image
+// are dropped.
+class Image {
+public:
+    Image(int width, int height, Rgb background = {255, 255, 255})
+        : w(width), h(height), pixels(size_t(width) * height, background) {}
+
+    int width() const { return w; }
+    int height() const { return h; }
+    const Rgb& at(int x, int y) const { return pixels[size_t(y) * w + x]; }
+
+    void set(int x, int y, Rgb c) {
+        if (x >= 0 && y >= 0 && x < w && y < h) pixels[size_t(y) * w + x] = c;
+    }
+
+    // Mixes c into pixel (x, y) with weight alpha in [0, 1].
+    void blend(int x, int y, Rgb c, float alpha) {
+        if (x < 0 || y < 0 || x >= w || y >= h || alpha <= 0) return;
+        Rgb& p = pixels[size_t(y) * w + x];
+        if (alpha >= 1) {
+            p = c;
+            return;
+        }
+        auto mix = [alpha](uint8_t a, uint8_t b) { return uint8_t(a + (b - a) * alpha + 0.5f); };
+        p = {mix(p.r, c.r), mix(p.g, c.g), mix(p.b, c.b)};
+    }
+
+    bool writePPM(const std::string& path) const {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        std::fprintf(f, "P6\n%d %d\n255\n", w, h);
+        bool ok = std::fwrite(pixels.data(), 3, pixels.size(), f) == pixels.size();
+        return std::fclose(f) == 0 && ok;
+    }
+
+    bool writePNG(const std::string& path) const {
+        // Scanlines with filter type 0, deflated below.
+        std::vector<uint8_t> raw;
+        raw.reserve(size_t(h) * (3 * w + 1));
+        for (int y = 0; y < h; y++) {
+            raw.push_back(0);
+            const uint8_t* row = &pixels[size_t(y) * w].r;
+            raw.insert(raw.end(), row, row + 3 * w);
+        }
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        std::vector<uint8_t> ihdr;
+        putBE(ihdr, w);
+        putBE(ihdr, h);
+        ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});  // 8-bit RGB, no interlace
+        chunk(png, "IHDR", ihdr);
+        chunk(png, "IDAT", zlib(raw));
+        chunk(png, "IEND", {});
+
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(png.data(), 1, png.size(), f) == png.size();
+        return std::fclose(f) == 0 && ok;
+    }
+
+    // PPM for a .ppm path, PNG otherwise.
+    bool write(const std::string& path) const {
+        bool ppm = path.size() >= 4 && path.compare(path.size() - 4, 4, ".ppm") == 0;
+        return ppm ? writePPM(path) : writePNG(path);
+    }
+
+private:
+    static void putBE(std::vector<uint8_t>& out, uint32_t v) {
+        for (int s = 24; s >= 0; s -= 8) out.push_back(uint8_t(v >> s));
+    }
+
+    static uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc = 0) {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < n; i++) crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    static void chunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data) {
+        putBE(png, uint32_t(data.size()));
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        putBE(png, crc32(&png[start], png.size() - start));
+    }
+
+    // zlib stream with one deflate block of fixed Huffman codes and greedy
+    // LZ77 matching through a single-entry hash table. Plots are mostly
+    // runs of background, which this already shrinks by two orders of
+    // magnitude.
+    static std::vector<uint8_t> zlib(const std::vector<uint8_t>& in) {
+        std::vector<uint8_t> out = {0x78, 0x01};
+        uint32_t bits = 0;
+        int count = 0;
+        auto put = [&](uint32_t v, int n) {  // n bits of v, LSB first
+            bits |= v << count;
+            count += n;
+            while (count >= 8) {
+                out.push_back(uint8_t(bits));
+                bits >>= 8;
+                count -= 8;
+            }
+        };
+        auto putCode = [&](uint32_t code, int n) {  // Huffman codes go MSB first
+            uint32_t r = 0;
+            for (int i = 0; i < n; i++) r |= ((code >> i) & 1) << (n - 1 - i);
+            put(r, n);
+        };
+        auto literal = [&](int sym) {
+            if (sym < 144) putCode(0x30 + sym, 8);
+            else if (sym < 256) putCode(0x190 + sym - 144, 9);
+            else if (sym < 280) putCode(sym - 256, 7);
+            else putCode(0xc0 + sym - 280, 8);
+        };
+        static const int lenBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+                                        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const int lenExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const int distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                         257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static const int distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        put(1, 1);  // final block
+        put(1, 2);  // fixed Huffman
+        const size_t WINDOW = 32768, MAX_LEN = 258;
+        std::vector<int64_t> last(1 << 15, -1);
+        size_t n = in.size(), i = 0;
+        while (i < n) {
+            size_t len = 0, dist = 0;
+            if (i + 3 <= n) {
+                uint32_t hsh = ((in[i] << 10) ^ (in[i + 1] << 5) ^ in[i + 2]) & 0x7fff;
+                int64_t cand = last[hsh];
+                last[hsh] = int64_t(i);
+                if (cand >= 0 && i - size_t(cand) <= WINDOW) {
+                    size_t limit = std::min(MAX_LEN, n - i);
+                    while (len < limit && in[size_t(cand) + len] == in[i + len]) len++;
+                    dist = i - size_t(cand);
+                }
+            }
+            if (len < 3) {
+                literal(in[i++]);
+                continue;
+            }
+            int lc = 28;
+            while (lenBase[lc] > int(len)) lc--;
+            literal(257 + lc);
+            put(uint32_t(len - lenBase[lc]), lenExtra[lc]);
+            int dc = 29;
+            while (distBase[dc] > int(dist)) dc--;
+            putCode(dc, 5);
+            put(uint32_t(dist - distBase[dc]), distExtra[dc]);
+            i += len;
+        }
+        literal(256);
+        if (count > 0) put(0, 8 - count);
+
+        uint32_t a = 1, b = 0;
+        for (uint8_t v : in) {
+            a = (a + v) % 65521;
+            b = (b + a) % 65521;
+        }
+        putBE(out, (b << 16) | a);
+        return out;
+    }
+
+    int w, h;
+    std::vector<Rgb> pixels;
+};
+
+// ============================================================================
+// GLYPH - font bitmap 5x8 dan cache mask per ukuran
+// ============================================================================
+
+// Printable ASCII (32..126) as 5 columns of 8 rows each, bit 0 at the top;
+// bit 7 holds descenders. Each glyph sits in a 6x8 cell.
+static const uint8_t FONT_5X8[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x08, 0x07, 0x03, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x80, 0x70, 0x30, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x00, 0x60, 0x60, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x00, 0x14, 0x00, 0x00},
+    {0x00, 0x40, 0x34, 0x00, 0x00}, {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x59, 0x09, 0x06}, {0x3E, 0x41, 0x5D, 0x59, 0x4E},
+    {0x7C, 0x12, 0x11, 0x12, 0x7C}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x41, 0x3E}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x41, 0x51, 0x73}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x1C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x26, 0x49, 0x49, 0x49, 0x32}, {0x03, 0x01, 0x7F, 0x01, 0x03}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x59, 0x49, 0x4D, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x41},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x41, 0x7F}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x03, 0x07, 0x08, 0x00}, {0x20, 0x54, 0x54, 0x78, 0x40},
+    {0x7F, 0x28, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x28}, {0x38, 0x44, 0x44, 0x28, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x00, 0x08, 0x7E, 0x09, 0x02}, {0x18, 0xA4, 0xA4, 0x9C, 0x78},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x40, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x78, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0xFC, 0x18, 0x24, 0x24, 0x18},
+    {0x18, 0x24, 0x24, 0x18, 0xFC}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x24},
+    {0x04, 0x04, 0x3F, 0x44, 0x24}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x4C, 0x90, 0x90, 0x90, 0x7C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x77, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02},
+};
+
+// Coverage of one character at one pixel size, 0..255 per pixel. The
+// glyph's advance is its width.
+struct GlyphMask {
+    int width, height;
+    std::vector<uint8_t> coverage;
+};
+
+// Glyph masks built on first use and kept for the life of the process, so
+// labels repeated on every image are scaled only once. Safe to share
+// between threads.
+class GlyphCache {
+public:
+    static GlyphCache& shared() {
+        static GlyphCache cache;
+        return cache;
+    }
+
+    // Cell width of one character at the given size (px per line).
+    static int advance(int size) { return std::max(1, int(std::lround(size * 0.75))); }
+
+    std::shared_ptr<const GlyphMask> get(char ch, int size) {
+        if (ch < 32 || ch > 126) ch = '?';
+        int key = size * 128 + ch;
+        std::lock_guard<std::mutex> lock(m);
+        auto it = glyphs.find(key);
+        if (it != glyphs.end()) return it->second;
+        std::shared_ptr<const GlyphMask> g = build(ch, size);
+        glyphs[key] = g;
+        return g;
+    }
+
+private:
+    // Box-filters the 6x8 cell onto size rows with 4x4 samples per pixel.
+    static std::shared_ptr<const GlyphMask> build(char ch, int size) {
+        auto g = std::make_shared<GlyphMask>();
+        g->width = advance(size);
+        g->height = size;
+        g->coverage.resize(size_t(g->width) * g->height);
+        const uint8_t* cols = FONT_5X8[ch - 32];
+        for (int v = 0; v < g->height; v++)
+            for (int u = 0; u < g->width; u++) {
+                int hits = 0;
+                for (int j = 0; j < 4; j++)
+                    for (int i = 0; i < 4; i++) {
+                        int col = int((u + (i + 0.5) / 4) * 6 / g->width);
+                        int row = int((v + (j + 0.5) / 4) * 8 / g->height);
+                        hits += col < 5 && (cols[col] >> row & 1);
+                    }
+                g->coverage[size_t(v) * g->width + u] = uint8_t(hits * 255 / 16);
+            }
+        return g;
+    }
+
+    std::mutex m;
+    std::unordered_map<int, std::shared_ptr<const GlyphMask>> glyphs;
+};
+
+// ============================================================================
+// CANVAS - daftar gambar yang dirasterisasi per tile secara paralel
+// ============================================================================
+
+// Software stand-in for the SFML draw calls the graphers use: line
+// segments (what sf::Lines and sf::LineStrip boil down to), filled
+// rectangles and text. Calls are only recorded; rasterize() bins them into
+// square tiles and draws the tiles in parallel, each shape clipped to the
+// tile, in the order they were recorded. Pixel (i, j) covers
+// [i, i + 1) x [j, j + 1) as in SFML.
+class Canvas {
+public:
+    Canvas(int width, int height, Rgb background = {255, 255, 255})
+        : w(width), h(height), background(background) {}
+
+    int width() const { return w; }
+    int height() const { return h; }
+
+    // Antialiased one-pixel line (Wu), clipped to the canvas here so that
+    // far off-screen endpoints (e.g. near a pole) cost nothing.
+    void line(double x0, double y0, double x1, double y1, Rgb c, float alpha = 1) {
+        if (!clip(x0, y0, x1, y1)) return;
+        shapes.push_back({Shape::LINE, float(x0), float(y0), float(x1), float(y1), c, alpha, nullptr});
+    }
+
+    void polyline(const std::vector<PathPoint>& pts, Rgb c, float alpha = 1) {
+        for (size_t i = 1; i < pts.size(); i++) line(pts[i - 1].x, pts[i - 1].y, pts[i].x, pts[i].y, c, alpha);
+    }
+
+    // Filled axis-aligned rectangle; edges off the pixel grid get partial
+    // coverage.
+    void rect(double x, double y, double width, double height, Rgb c, float alpha = 1) {
+        if (width <= 0 || height <= 0) return;
+        shapes.push_back({Shape::RECT, float(x), float(y), float(x + width), float(y + height), c, alpha, nullptr});
+    }
+
+    // Text with its top-left corner at (x, y), snapped to whole pixels;
+    // size is the line height in pixels.
+    void text(double x, double y, const std::string& s, int size, Rgb c) {
+        if (size <= 0) return;
+        int px = int(std::lround(x)), py = int(std::lround(y));
+        for (char ch : s) {
+            if (ch != ' ') {
+                std::shared_ptr<const GlyphMask> g = GlyphCache::shared().get(ch, size);
+                shapes.push_back({Shape::GLYPH, float(px), float(py), float(px + g->width), float(py + g->height), c, 1, g});
+            }
+            px += GlyphCache::advance(size);
+        }
+    }
+
+    static int textWidth(const std::string& s, int size) { return int(s.size()) * GlyphCache::advance(size); }
+
+    // Draws everything recorded so far. Without a pool the tiles run on the
+    // calling thread.
+    Image rasterize(ThreadPool* pool = nullptr, int tile = 64) const {
+        Image img(w, h, background);
+        int tilesX = (w + tile - 1) / tile, tilesY = (h + tile - 1) / tile;
+        std::vector<std::vector<uint32_t>> bins(size_t(tilesX) * tilesY);
+        for (size_t k = 0; k < shapes.size(); k++) {
+            const Shape& s = shapes[k];
+            // Lines reach one pixel past their endpoints.
+            float pad = s.kind == Shape::LINE ? 1.5f : 0;
+            int bx0 = std::max(0, int(std::floor(std::min(s.x0, s.x1) - pad)) / tile);
+            int by0 = std::max(0, int(std::floor(std::min(s.y0, s.y1) - pad)) / tile);
+            int bx1 = std::min(tilesX - 1, int(std::floor(std::max(s.x0, s.x1) + pad)) / tile);
+            int by1 = std::min(tilesY - 1, int(std::floor(std::max(s.y0, s.y1) + pad)) / tile);
+            for (int ty = by0; ty <= by1; ty++)
+                for (int tx = bx0; tx <= bx1; tx++) bins[size_t(ty) * tilesX + tx].push_back(uint32_t(k));
+        }
+        auto drawTiles = [&](size_t b, size_t e) {
+            for (size_t t = b; t < e; t++) {
+                Tile r{int(t % tilesX) * tile, int(t / tilesX) * tile, 0, 0};
+                r.x1 = std::min(w, r.x0 + tile);
+                r.y1 = std::min(h, r.y0 + tile);
+                for (uint32_t k : bins[t]) draw(img, shapes[k], r);
+            }
+        };
+        if (pool) pool->parallelFor(bins.size(), 1, drawTiles);
+        else drawTiles(0, bins.size());
+        return img;
+    }
+
+private:
+    struct Shape {
+        enum Kind { LINE, RECT, GLYPH } kind;
+        float x0, y0, x1, y1;  // endpoints, or the corners of a box
+        Rgb color;
+        float alpha;
+        std::shared_ptr<const GlyphMask> glyph;
+    };
+
+    // Pixel bounds of one tile, [x0, x1) x [y0, y1).
+    struct Tile {
+        int x0, y0, x1, y1;
+    };
+
+    static void draw(Image& img, const Shape& s, const Tile& r) {
+        switch (s.kind) {
+        case Shape::LINE: drawLine(img, s, r); break;
+        case Shape::RECT: drawRect(img, s, r); break;
+        case Shape::GLYPH: drawGlyph(img, s, r); break;
+        }
+    }
+
+    // Wu's algorithm, stepping only over the tile's share of the major
+    // axis. Every column's coverage depends on the whole segment alone, so
+    // tiles meet without seams.
+    static void drawLine(Image& img, const Shape& s, Tile r) {
+        // Pixel centres sit at integers for the stepping below.
+        double x0 = s.x0 - 0.5, y0 = s.y0 - 0.5, x1 = s.x1 - 0.5, y1 = s.y1 - 0.5;
+        bool steep = std::fabs(y1 - y0) > std::fabs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+            std::swap(r.x0, r.y0);
+            std::swap(r.x1, r.y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        auto plot = [&](int x, int y, double coverage) {
+            if (x < r.x0 || x >= r.x1 || y < r.y0 || y >= r.y1) return;
+            if (steep) img.blend(y, x, s.color, float(s.alpha * coverage));
+            else img.blend(x, y, s.color, float(s.alpha * coverage));
+        };
+        auto plotPair = [&](int x, double y, double coverage) {
+            double f = y - std::floor(y);
+            int iy = int(std::floor(y));
+            plot(x, iy, (1 - f) * coverage);
+            plot(x, iy + 1, f * coverage);
+        };
+        double dx = x1 - x0, g = dx > 0 ? (y1 - y0) / dx : 0;
+        int xa = int(std::lround(x0)), xb = int(std::lround(x1));
+        if (xa == xb) {
+            // Shorter than a pixel: one column weighted by its length.
+            plotPair(xa, 0.5 * (y0 + y1), dx);
+            return;
+        }
+        // End columns are weighted by how much of them the segment spans.
+        plotPair(xa, y0 + g * (xa - x0), xa + 0.5 - x0);
+        plotPair(xb, y1 + g * (xb - x1), x1 - (xb - 0.5));
+        int from = std::max(xa + 1, r.x0), to = std::min(xb - 1, r.x1 - 1);
+        for (int x = from; x <= to; x++) plotPair(x, y0 + g * (x - x0), 1);
+    }
+
+    static void drawRect(Image& img, const Shape& s, const Tile& r) {
+        // Overlap of pixel [i, i + 1) with [lo, hi).
+        auto cover = [](int i, float lo, float hi) { return std::max(0.0f, std::min(hi, i + 1.0f) - std::max(lo, float(i))); };
+        int x0 = std::max(r.x0, int(std::floor(s.x0))), x1 = std::min(r.x1, int(std::ceil(s.x1)));
+        int y0 = std::max(r.y0, int(std::floor(s.y0))), y1 = std::min(r.y1, int(std::ceil(s.y1)));
+        for (int y = y0; y < y1; y++) {
+            float cy = cover(y, s.y0, s.y1);
+            for (int x = x0; x < x1; x++) img.blend(x, y, s.color, s.alpha * cy * cover(x, s.x0, s.x1));
+        }
+    }
+
+    static void drawGlyph(Image& img, const Shape& s, const Tile& r) {
+        const GlyphMask& g = *s.glyph;
+        int gx = int(s.x0), gy = int(s.y0);
+        int x0 = std::max(r.x0, gx), x1 = std::min(r.x1, gx + g.width);
+        int y0 = std::max(r.y0, gy), y1 = std::min(r.y1, gy + g.height);
+        for (int y = y0; y < y1; y++)
+            for (int x = x0; x < x1; x++) {
+                uint8_t c = g.coverage[size_t(y - gy) * g.width + (x - gx)];
+                if (c) img.blend(x, y, s.color, c / 255.0f);
+            }
+    }
+
+    // Liang-Barsky against the canvas grown by two pixels, so the clipped
+    // ends (drawn faded by Wu) stay out of sight.
+    bool clip(double& x0, double& y0, double& x1, double& y1) const {
+        if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) || !std::isfinite(y1)) return false;
+        double t0 = 0, t1 = 1, dx = x1 - x0, dy = y1 - y0;
+        auto edge = [&](double p, double q) {
+            if (p == 0) return q >= 0;
+            double t = q / p;
+            if (p < 0) t0 = std::max(t0, t);
+            else t1 = std::min(t1, t);
+            return t0 <= t1;
+        };
+        if (!edge(-dx, x0 + 2) || !edge(dx, w + 2 - x0) || !edge(-dy, y0 + 2) || !edge(dy, h + 2 - y0))
+            return false;
+        double ax = x0, ay = y0;
+        x0 = ax + t0 * dx;
+        y0 = ay + t0 * dy;
+        x1 = ax + t1 * dx;
+        y1 = ay + t1 * dy;
+        return true;
+    }
+
+    int w, h;
+    Rgb background;
+    std::vector<Shape> shapes;
+};
@@ -0,0 +1,453 @@
+// Headless renderer: plots 2D expressions, or surfaces z = f(x, y) as
+// wireframes, into PNG, PPM, SVG or PDF files without a window, using the
+// same parser, JIT, samplers and surface tessellation as the interactive
+// graphers. No SFML needed:
+//   g++ -std=c++17 -O2 -pthread render.cpp -o render
+//
+//   render [-s 800x600] [-x -10:10] [-y -7.5:7.5] -o out.png "sin(x)" "x^2 + y^2 = 4"
+//   render -3d [-x -3:3] [-y -3:3] -o surface.png "sin(x)*cos(y)"
+//   render [-j threads] -f jobs.txt
+//
+// The output format follows the file extension. Without -y the y range is
+// centred on 0 at the x scale, or equal to the x range for surfaces. A job
+// file has one image per line, "out.png 800x600 xmin xmax ymin ymax expr;
+// expr; ...", prefixed with "3d " for surfaces, and its jobs are rendered
+// in parallel. Blank lines and lines starting with # are skipped.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "camera.hpp"
+#include "jit.hpp"
+#include "pool.hpp"
+#include "raster.hpp"
+#include "samples.hpp"
+#include "surface.hpp"
+#include "vector.hpp"
+
+struct RenderJob {
+    std::string output;
+    int width = 800, height = 600;
+    double x0 = -10, x1 = 10, y0 = NAN, y1 = NAN;
+    bool surface = false;  // expressions are z = f(x, y), drawn in 3D
+    std::vector<std::string> exprs;
+};
+
+// Surface jobs: the 3D grapher's start view, and lattice points sampled
+// per pool task.
+const float SURFACE_ROT_X = -0.5f, SURFACE_ROT_Y = 0.3f;
+const size_t SURFACE_SAMPLE_CHUNK = 256;
+
+// "800x600" or "-10:10" (the job file uses spaces instead of the colon).
+static bool parseSize(const char* s, int& w, int& h) {
+    return sscanf(s, "%dx%d", &w, &h) == 2 && w > 0 && h > 0 && w <= 16384 && h <= 16384;
+}
+
+static bool parseRange(const char* s, double& lo, double& hi) {
+    return sscanf(s, "%lf:%lf", &lo, &hi) == 2 && std::isfinite(lo) && std::isfinite(hi) && lo < hi;
+}
+
+// True if [lo, hi] across the given pixels has a finite, nonzero scale and
+// one pixel still moves x at the magnitude of the ends; the grid and the
+// curve sampler step through the range and need both.
+static bool usableRange(double lo, double hi, int pixels) {
+    double perUnit = pixels / (hi - lo), perPixel = (hi - lo) / pixels;
+    double m = std::max(std::fabs(lo), std::fabs(hi));
+    return std::isfinite(lo) && std::isfinite(hi) && lo < hi && std::isfinite(perUnit) && perUnit > 0 &&
+           m + perPixel != m;
+}
+
+static std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r"), e = s.find_last_not_of(" \t\r");
+    return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+}
+
+static bool loadJobs(const char* path, std::vector<RenderJob>& jobs) {
+    std::ifstream f(path);
+    if (!f) {
+        fprintf(stderr, "Tidak bisa membuka %s\n", path);
+        return false;
+    }
+    std::string line;
+    for (int lineNo = 1; std::getline(f, line); lineNo++) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        RenderJob job;
+        std::string size, rest;
+        if (line.compare(0, 3, "3d ") == 0) {
+            job.surface = true;
+            in.ignore(3);
+        }
+        if (!(in >> job.output >> size >> job.x0 >> job.x1 >> job.y0 >> job.y1) ||
+            !parseSize(size.c_str(), job.width, job.height) || !usableRange(job.x0, job.x1, job.width) ||
+            !usableRange(job.y0, job.y1, job.height)) {
+            fprintf(stderr, "%s:%d: format baris salah\n", path, lineNo);
+            return false;
+        }
+        std::getline(in, rest);
+        std::istringstream list(rest);
+        for (std::string e; std::getline(list, e, ';');)
+            if (!trim(e).empty()) job.exprs.push_back(trim(e));
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// Curve colours, in the graphers' order, and the label text size.
+const Rgb PLOT_COLORS[] = {{50, 90, 200}, {200, 50, 90}, {50, 200, 90}, {200, 150, 50}, {150, 50, 200}};
+const int LABEL_SIZE = 12;
+
+// Grid step of 1, 2 or 5 times a power of ten giving lines about 50 px apart.
+static double gridStep(double pxPerUnit) {
+    double step = std::pow(10.0, std::floor(std::log10(50 / pxPerUnit)));
+    for (double k : {1.0, 2.0, 5.0})
+        if (step * k * pxPerUnit >= 50) return step * k;
+    return step * 10;
+}
+
+static std::string formatTick(double v) {
+    char buf[32];
+    snprintf(buf, sizeof buf, "%g", std::fabs(v) < 1e-12 ? 0.0 : v);
+    return buf;
+}
+
+// Legend in the top-left corner, like the function list of the grapher.
+template <typename Target>
+static void drawLegend(const RenderJob& job, Target& canvas) {
+    if (job.exprs.empty()) return;
+    int rowH = LABEL_SIZE + 6, boxW = 0;
+    for (const std::string& e : job.exprs) boxW = std::max(boxW, Target::textWidth(e, LABEL_SIZE));
+    boxW += 30;
+    int boxH = int(job.exprs.size()) * rowH + 6;
+    canvas.rect(8, 8, boxW, boxH, {255, 255, 255}, 0.85f);
+    canvas.line(8.5, 8.5, 8.5 + boxW, 8.5, {200, 200, 200});
+    canvas.line(8.5 + boxW, 8.5, 8.5 + boxW, 8.5 + boxH, {200, 200, 200});
+    canvas.line(8.5 + boxW, 8.5 + boxH, 8.5, 8.5 + boxH, {200, 200, 200});
+    canvas.line(8.5, 8.5 + boxH, 8.5, 8.5, {200, 200, 200});
+    for (size_t k = 0; k < job.exprs.size(); k++) {
+        double y = 14 + double(k) * rowH;
+        canvas.rect(14, y + 1, 10, 10, PLOT_COLORS[k % 5]);
+        canvas.text(30, y, job.exprs[k], LABEL_SIZE, {0, 0, 0});
+    }
+}
+
+// Draws a 2D job onto a Canvas or a VectorDocument; false (with the reason
+// on stderr) if an expression does not compile.
+template <typename Target>
+static bool drawPlot(const RenderJob& job, Target& canvas) {
+    double pxPerX = job.width / (job.x1 - job.x0), pxPerY = job.height / (job.y1 - job.y0);
+    auto sx = [&](double x) { return (x - job.x0) * pxPerX; };
+    auto sy = [&](double y) { return (job.y1 - y) * pxPerY; };
+    // Straight lines land on pixel centres so they stay one pixel wide.
+    auto centre = [](double p) { return std::floor(p) + 0.5; };
+
+    const Rgb GRID = {230, 230, 230}, AXIS = {180, 80, 80}, LABEL = {100, 100, 100};
+    double stepX = gridStep(pxPerX), stepY = gridStep(pxPerY);
+    for (double x = std::ceil(job.x0 / stepX) * stepX; x <= job.x1; x += stepX)
+        canvas.line(centre(sx(x)), 0, centre(sx(x)), job.height, GRID);
+    for (double y = std::ceil(job.y0 / stepY) * stepY; y <= job.y1; y += stepY)
+        canvas.line(0, centre(sy(y)), job.width, centre(sy(y)), GRID);
+    canvas.line(centre(sx(0)), 0, centre(sx(0)), job.height, AXIS);
+    canvas.line(0, centre(sy(0)), job.width, centre(sy(0)), AXIS);
+
+    // Tick labels beside the axes, kept inside the image when an axis is
+    // off-screen.
+    double axisX = std::min(std::max(sx(0), 0.0), job.width - 40.0);
+    double axisY = std::min(std::max(sy(0), 0.0), job.height - 20.0);
+    for (double x = std::ceil(job.x0 / stepX) * stepX; x <= job.x1; x += stepX) {
+        std::string label = formatTick(x);
+        double left = sx(x) - Target::textWidth(label, LABEL_SIZE) / 2;
+        if (std::fabs(x) > stepX * 1e-6 && left >= 0 && left + Target::textWidth(label, LABEL_SIZE) <= job.width)
+            canvas.text(left, axisY + 5, label, LABEL_SIZE, LABEL);
+    }
+    for (double y = std::ceil(job.y0 / stepY) * stepY; y <= job.y1; y += stepY) {
+        double top = sy(y) - LABEL_SIZE / 2;
+        if (std::fabs(y) > stepY * 1e-6 && top >= 0 && top + LABEL_SIZE <= job.height)
+            canvas.text(axisX + 5, top, formatTick(y), LABEL_SIZE, LABEL);
+    }
+
+    Parser parser;
+    bool ok = true;
+    for (size_t k = 0; k < job.exprs.size(); k++) {
+        const std::string& expr = job.exprs[k];
+        Rgb color = PLOT_COLORS[k % 5];
+
+        // A relation "lhs = rhs" is plotted implicitly as lhs - rhs = 0.
+        std::string source = expr, err;
+        size_t eq = expr.find('=');
+        bool implicit = eq != std::string::npos;
+        if (implicit) {
+            std::string lhs = trim(expr.substr(0, eq)), rhs = trim(expr.substr(eq + 1));
+            if (lhs.empty() || rhs.empty() || rhs.find('=') != std::string::npos) err = "Relasi harus berbentuk kiri = kanan";
+            source = "(" + lhs + ")-(" + rhs + ")";
+        }
+        Program prog;
+        if (err.empty()) {
+            auto t = parser.parse(source, err);
+            if (err.empty()) prog = parser.toRPN(t, err);
+        }
+        if (err.empty() && prog.usesY && !implicit) err = "Variabel y hanya untuk relasi (mis. x^2 + y^2 = 4)";
+        if (err.empty() && prog.empty()) err = "Ekspresi kosong";
+        if (!err.empty()) {
+            fprintf(stderr, "%s: '%s': %s\n", job.output.c_str(), expr.c_str(), err.c_str());
+            ok = false;
+            continue;
+        }
+        JitProgram jit;
+        jit.compile(prog);
+
+        if (implicit) {
+            auto f = [&](double x, double y, double& v) {
+                bool defined;
+                v = jit.eval(x, y, defined);
+                return defined;
+            };
+            auto bound = [&](Interval x, Interval y) { return parser.evalInterval(prog, x, y); };
+            std::vector<PathPoint> ends;
+            for (const CurveSegment& s : traceImplicit(f, bound, job.x0, job.y0, job.x1, job.y1, std::max(pxPerX, pxPerY))) {
+                ends.push_back({sx(s.x0), sy(s.y0)});
+                ends.push_back({sx(s.x1), sy(s.y1)});
+            }
+            for (const std::vector<PathPoint>& path : joinSegments(ends)) canvas.polyline(path, color);
+            continue;
+        }
+
+        auto f = [&](double x, double& y) {
+            bool defined;
+            y = jit.eval(x, 0, defined);
+            return defined;
+        };
+        CurveTolerance tol{pxPerX, pxPerY};
+        tol.yMin = job.y0;
+        tol.yMax = job.y1;
+        std::vector<CurvePoint> points =
+            sampleCurve(f, job.x0, job.x1, tol, std::max(1, job.width / 8), ProgramCurveBound{parser, prog});
+        // One polyline per run of defined points.
+        std::vector<PathPoint> run;
+        for (size_t i = 0; i <= points.size(); i++) {
+            if (i < points.size() && points[i].ok) {
+                run.push_back({sx(points[i].x), sy(points[i].y)});
+                continue;
+            }
+            canvas.polyline(run, color);
+            run.clear();
+        }
+    }
+
+    drawLegend(job, canvas);
+
+    return ok;
+}
+
+// Draws a surface job: every expression is tessellated like in the 3D
+// grapher, its domain mapped onto the grapher's box with z scaled alike,
+// and its wireframe strips are projected through the grapher's start
+// camera, fitted to the image. No depth test, as in the grapher without
+// filled surfaces.
+template <typename Target>
+static bool drawSurfaces(const RenderJob& job, Target& canvas, ThreadPool& pool) {
+    // Camera fitted so the axis cube fills 90% of the smaller image side;
+    // the projection is linear in scale and origin.
+    Camera unit = Camera::orbit(SURFACE_ROT_X, SURFACE_ROT_Y, 1, 0, 0);
+    float lo[2] = {INFINITY, INFINITY}, hi[2] = {-INFINITY, -INFINITY};
+    for (int c = 0; c < 8; c++) {
+        float p[2];
+        unit.project(c & 1 ? GRID_RANGE : -GRID_RANGE, c & 2 ? GRID_RANGE : -GRID_RANGE,
+                     c & 4 ? GRID_RANGE : -GRID_RANGE, p[0], p[1]);
+        for (int a = 0; a < 2; a++) {
+            lo[a] = std::min(lo[a], p[a]);
+            hi[a] = std::max(hi[a], p[a]);
+        }
+    }
+    float scale = 0.9f * std::min(job.width / (hi[0] - lo[0]), job.height / (hi[1] - lo[1]));
+    const Camera cam = Camera::orbit(SURFACE_ROT_X, SURFACE_ROT_Y, scale, 0.5f * job.width - scale * 0.5f * (lo[0] + hi[0]),
+                                     0.5f * job.height - scale * 0.5f * (lo[1] + hi[1]));
+
+    // Axes through the origin of the box, coloured like the grapher's.
+    const Rgb AXIS[3] = {{220, 50, 50}, {50, 160, 50}, {50, 50, 220}};
+    const char* AXIS_NAME[3] = {"X", "Y", "Z"};
+    for (int a = 0; a < 3; a++) {
+        float p[3] = {0, 0, 0}, x0, y0, x1, y1;
+        p[a] = -GRID_RANGE;
+        cam.project(p[0], p[1], p[2], x0, y0);
+        p[a] = GRID_RANGE;
+        cam.project(p[0], p[1], p[2], x1, y1);
+        canvas.line(x0, y0, x1, y1, AXIS[a]);
+        canvas.text(x1 + 5, y1 - 5, AXIS_NAME[a], LABEL_SIZE, AXIS[a]);
+    }
+
+    const double stepX = (job.x1 - job.x0) / GRID_MAX, stepY = (job.y1 - job.y0) / GRID_MAX;
+    const double zScale = 2 * GRID_RANGE / std::max(job.x1 - job.x0, job.y1 - job.y0);
+    const std::atomic<bool> never{false};
+    Parser parser;
+    bool ok = true;
+    for (size_t k = 0; k < job.exprs.size(); k++) {
+        const std::string& expr = job.exprs[k];
+        std::string err;
+        Program prog;
+        if (expr.find('=') != std::string::npos) {
+            err = "Permukaan ditulis sebagai f(x, y), tanpa '='";
+        } else {
+            auto t = parser.parse(expr, err);
+            if (err.empty()) prog = parser.toRPN(t, err);
+        }
+        if (err.empty() && prog.empty()) err = "Ekspresi kosong";
+        if (!err.empty()) {
+            fprintf(stderr, "%s: '%s': %s\n", job.output.c_str(), expr.c_str(), err.c_str());
+            ok = false;
+            continue;
+        }
+        JitProgram jit;
+        jit.compile(prog);
+
+        SurfaceMesh m;
+        auto sample = [&](const std::vector<int>& points) {
+            pool.parallelFor(points.size(), SURFACE_SAMPLE_CHUNK, [&](size_t begin, size_t end) {
+                thread_local std::vector<double> xs, ys, z;
+                thread_local std::vector<uint8_t> defined;
+                size_t n = end - begin;
+                xs.resize(n); ys.resize(n); z.resize(n); defined.resize(n);
+                for (size_t q = 0; q < n; q++) {
+                    xs[q] = job.x0 + points[begin + q] / (GRID_MAX + 1) * stepX;
+                    ys[q] = job.y0 + points[begin + q] % (GRID_MAX + 1) * stepY;
+                }
+                jit.evalBatch(xs.data(), ys.data(), z.data(), defined.data(), n);
+                for (size_t q = 0; q < n; q++) {
+                    int p = points[begin + q];
+                    m.z[p] = z[q] * zScale;
+                    m.zf[p] = float(m.z[p]);
+                    m.ok[p] = defined[q];
+                    m.sampled[p] = 1;
+                }
+            });
+            m.samples += points.size();
+        };
+        // One pixel of deviation, as the grapher's LOD tolerance.
+        tessellateSurface(m, 1 / scale, sample, never);
+
+        // Every lattice point of every strip is projected in one batch.
+        std::vector<int> strips, runs;
+        wireframeStrips(m, [&](const int* points, size_t n) {
+            strips.insert(strips.end(), points, points + n);
+            runs.push_back(int(n));
+        });
+        size_t count = strips.size();
+        std::vector<float> px(count), py(count), pz(count), sx(count), sy(count);
+        for (size_t q = 0; q < count; q++) {
+            px[q] = latticeCoord(strips[q] / (GRID_MAX + 1));
+            py[q] = latticeCoord(strips[q] % (GRID_MAX + 1));
+            pz[q] = m.zf[strips[q]];
+        }
+        cam.projectBatch(px.data(), py.data(), pz.data(), sx.data(), sy.data(), count);
+        std::vector<PathPoint> path;
+        size_t first = 0;
+        for (int n : runs) {
+            path.clear();
+            for (size_t q = first; q < first + n; q++) path.push_back({sx[q], sy[q]});
+            canvas.polyline(path, PLOT_COLORS[k % 5]);
+            first += n;
+        }
+    }
+
+    drawLegend(job, canvas);
+    return ok;
+}
+
+// Draws one job onto a Canvas or a VectorDocument; false (with the reason
+// on stderr) if an expression does not compile.
+template <typename Target>
+static bool drawJob(const RenderJob& job, Target& canvas, ThreadPool& pool) {
+    return job.surface ? drawSurfaces(job, canvas, pool) : drawPlot(job, canvas);
+}
+
+static bool hasSuffix(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// Renders one job into its file: .svg and .pdf as vector graphics, anything
+// else as an image rasterised in tiles on the pool.
+static bool renderJob(const RenderJob& job, ThreadPool& pool) {
+    bool ok, written;
+    if (hasSuffix(job.output, ".svg") || hasSuffix(job.output, ".pdf")) {
+        VectorDocument doc(job.width, job.height);
+        ok = drawJob(job, doc, pool);
+        written = doc.write(job.output);
+    } else {
+        Canvas canvas(job.width, job.height);
+        ok = drawJob(job, canvas, pool);
+        written = canvas.rasterize(&pool).write(job.output);
+    }
+    if (!written) {
+        fprintf(stderr, "Gagal menulis %s\n", job.output.c_str());
+        return false;
+    }
+    return ok;
+}
+
+static int usage() {
+    fprintf(stderr,
+            "Pemakaian: render [-3d] [-s WxH] [-x xmin:xmax] [-y ymin:ymax] -o out.png ekspresi...\n"
+            "           render [-j thread] -f jobs.txt\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    RenderJob single;
+    const char* jobFile = nullptr;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(a, "-3d")) single.surface = true;
+        else if (!strcmp(a, "-o") && hasValue) single.output = argv[++i];
+        else if (!strcmp(a, "-f") && hasValue) jobFile = argv[++i];
+        else if (!strcmp(a, "-j") && hasValue) threads = unsigned(atoi(argv[++i]));
+        else if (!strcmp(a, "-s") && hasValue) {
+            if (!parseSize(argv[++i], single.width, single.height)) return usage();
+        } else if (!strcmp(a, "-x") && hasValue) {
+            if (!parseRange(argv[++i], single.x0, single.x1)) return usage();
+        } else if (!strcmp(a, "-y") && hasValue) {
+            if (!parseRange(argv[++i], single.y0, single.y1)) return usage();
+        } else {
+            single.exprs.push_back(a);
+        }
+    }
+
+    std::vector<RenderJob> jobs;
+    if (jobFile) {
+        if (!loadJobs(jobFile, jobs)) return 1;
+    } else {
+        if (single.output.empty() || single.exprs.empty()) return usage();
+        if (std::isnan(single.y0) && single.surface) {
+            single.y0 = single.x0;
+            single.y1 = single.x1;
+        } else if (std::isnan(single.y0)) {
+            double half = 0.5 * (single.x1 - single.x0) * single.height / single.width;
+            single.y0 = -half;
+            single.y1 = half;
+        }
+        if (!usableRange(single.x0, single.x1, single.width) || !usableRange(single.y0, single.y1, single.height))
+            return usage();
+        jobs.push_back(single);
+    }
+
+    // One task per image, and the tiles of each image are spread over the
+    // same pool, so a single large image uses every core as well.
+    ThreadPool pool(threads);
+    std::vector<uint8_t> done(jobs.size(), 0);
+    pool.parallelFor(jobs.size(), 1, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) done[i] = renderJob(jobs[i], pool);
+    });
+    int failed = 0;
+    for (uint8_t d : done) failed += !d;
+    if (jobFile) printf("%zu gambar, %d gagal\n", jobs.size(), failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "parser.hpp"
+
+// ============================================================================
+// SAMPEL KOLOM - ring buffer y(x) per kolom piksel
+// ============================================================================
+
+// Holds one sample per screen column for x = (px - originX) / scale. The
+// storage is a ring: column px lives at slot (head + px) % width, so a
+// horizontal pan by a whole number of pixels only moves head and evaluates
+// the newly exposed strip. Any other view change refills every column.
+class ColumnSamples {
+public:
+    // Makes the samples current for the given view. eval(xs, ys, ok, n)
+    // fills n samples, like Parser::evalBatch. Returns the number of
+    // columns that had to be evaluated.
+    template <typename Eval>
+    int update(double originX, double scale, int width, Eval eval) {
+        double shift = originX - viewOrigin;
+        if (!valid || scale != viewScale || width != cols ||
+            shift != std::floor(shift) || std::fabs(shift) >= width) {
+            ys.resize(width);
+            okMask.resize(width);
+            head = 0;
+            viewOrigin = originX;
+            viewScale = scale;
+            cols = width;
+            valid = true;
+            fill(0, width, eval);
+            return width;
+        }
+
+        // Content moves right by d pixels: new column px is old column px - d.
+        int d = int(shift);
+        if (d == 0) return 0;
+        head = ((head - d) % width + width) % width;
+        viewOrigin = originX;
+        if (d > 0) fill(0, d, eval);
+        else fill(width + d, -d, eval);
+        return d > 0 ? d : -d;
+    }
+
+    // Forces a full refill on the next update (e.g. the expression changed).
+    void invalidate() { valid = false; }
+
+    int width() const { return cols; }
+    double x(int px) const { return (px - viewOrigin) / viewScale; }
+    double y(int px) const { return ys[slot(px)]; }
+    bool ok(int px) const { return okMask[slot(px)] != 0; }
+
+private:
+    int slot(int px) const {
+        int i = head + px;
+        return i >= cols ? i - cols : i;
+    }
+
+    // Evaluates columns [first, first + n) through a contiguous scratch
+    // strip, then scatters them into the ring.
+    template <typename Eval>
+    void fill(int first, int n, Eval eval) {
+        xs.resize(n);
+        strip.resize(n);
+        stripOk.resize(n);
+        for (int i = 0; i < n; i++) xs[i] = x(first + i);
+        eval(xs.data(), strip.data(), stripOk.data(), size_t(n));
+        for (int i = 0; i < n; i++) {
+            int s = slot(first + i);
+            ys[s] = strip[i];
+            okMask[s] = stripOk[i];
+        }
+    }
+
+    std::vector<double> ys;
+    std::vector<uint8_t> okMask;
+    std::vector<double> xs, strip;
+    std::vector<uint8_t> stripOk;
+    int head = 0;
+    int cols = 0;
+    double viewOrigin = 0;
+    double viewScale = 0;
+    bool valid = false;
+};
+
+// ============================================================================
+// SAMPLING ADAPTIF - subdivisi kurva berdasarkan toleransi layar
+// ============================================================================
+
+// One vertex of an adaptively sampled curve. A point with ok == false lifts
+// the pen: the polyline continues as a new piece after it.
+struct CurvePoint {
+    double x, y;
+    bool ok;
+};
+
+// Screen-space limits for subdivision. pxPerX / pxPerY map world units to
+// pixels; flatness is the largest allowed distance (px) between a chord's
+// midpoint and the curve; below minStep (px) an interval is never split
+// again, and without interval bounds a rise taller than jump (px) across
+// such an interval is taken as a discontinuity rather than a steep slope.
+// [yMin, yMax] is the visible world range used to cull bounded intervals.
+struct CurveTolerance {
+    double pxPerX, pxPerY;
+    double flatness = 0.5;
+    double minStep = 0.125;
+    double jump = 16;
+    double yMin = -INFINITY, yMax = INFINITY;
+};
+
+// Interval bound for the sampler: bound(x0, x1, slope) encloses f (and
+// f' in slope) over [x0, x1], e.g. via Parser::evalIntervalSlope. The
+// default knows nothing and leaves every decision to point samples.
+struct NoCurveBound {
+    bool known() const { return false; }
+    Interval operator()(double, double, Interval& slope) const {
+        slope = {-INFINITY, INFINITY};
+        return {-INFINITY, INFINITY, false, false};
+    }
+};
+
+// Wraps a Program for the sampler; the program must not use y.
+struct ProgramCurveBound {
+    const Parser& parser;
+    const Program& prog;
+
+    bool known() const { return true; }
+    Interval operator()(double x0, double x1, Interval& slope) const {
+        return parser.evalIntervalSlope(prog, {x0, x1}, Interval::point(0), &slope);
+    }
+};
+
+// f(x, y) stores f(x) in y and returns false where f is undefined.
+template <typename F>
+CurvePoint curvePoint(F& f, double x) {
+    double y = 0;
+    bool ok = f(x, y);
+    return {x, y, ok && std::isfinite(y)};
+}
+
+inline void appendCurvePoint(std::vector<CurvePoint>& out, const CurvePoint& p) {
+    if (!p.ok && (out.empty() || !out.back().ok)) return;
+    out.push_back(p);
+}
+
+// Appends the points of (a, b] to out, splitting the interval while the
+// chord deviates from the curve or a domain edge lies inside it. With an
+// interval bound, intervals proven off-screen or proven flat (the slope
+// range limits the chord error) are accepted without sampling, and poles
+// are split exactly instead of guessed from the rise.
+template <typename F, typename B>
+void subdivideCurve(F& f, const B& bound, const CurveTolerance& tol, const CurvePoint& a,
+                    const CurvePoint& b, std::vector<CurvePoint>& out) {
+    bool split = (b.x - a.x) * tol.pxPerX > tol.minStep;
+    bool pole = false;
+    if (bound.known()) {
+        Interval slope;
+        Interval v = bound(a.x, b.x, slope);
+        bool smooth = v.defined && v.continuous && a.ok && b.ok;
+        // A monotone stretch lies between its endpoint values.
+        if (smooth && (slope.lo >= 0 || slope.hi <= 0)) {
+            v.lo = std::max(v.lo, std::min(a.y, b.y));
+            v.hi = std::min(v.hi, std::max(a.y, b.y));
+        }
+        if (v.empty() || v.hi < tol.yMin || v.lo > tol.yMax) {
+            appendCurvePoint(out, {b.x, b.y, false});
+            appendCurvePoint(out, b);
+            return;
+        }
+        if (smooth && (slope.hi - slope.lo) * (b.x - a.x) * 0.25 * tol.pxPerY <= tol.flatness) {
+            appendCurvePoint(out, b);
+            return;
+        }
+        if (!split) {
+            if (!v.continuous) appendCurvePoint(out, {b.x, b.y, false});
+            appendCurvePoint(out, b);
+            return;
+        }
+        pole = !v.continuous;
+    }
+    if (split) {
+        CurvePoint m = curvePoint(f, 0.5 * (a.x + b.x));
+        bool flat = a.ok && b.ok && m.ok &&
+                    std::fabs(m.y - 0.5 * (a.y + b.y)) * tol.pxPerY <= tol.flatness;
+        bool gap = !a.ok && !b.ok && !m.ok;
+        if ((!flat || pole) && !gap) {
+            subdivideCurve(f, bound, tol, a, m, out);
+            subdivideCurve(f, bound, tol, m, b, out);
+            return;
+        }
+    } else if (a.ok && b.ok && std::fabs(b.y - a.y) * tol.pxPerY > tol.jump) {
+        appendCurvePoint(out, {b.x, b.y, false});
+    }
+    appendCurvePoint(out, b);
+}
+
+template <typename F>
+void subdivideCurve(F& f, const CurveTolerance& tol, const CurvePoint& a, const CurvePoint& b,
+                    std::vector<CurvePoint>& out) {
+    subdivideCurve(f, NoCurveBound(), tol, a, b, out);
+}
+
+// Samples f over [x0, x1] starting from `coarse` equal intervals and
+// refining each one only where needed. Smooth stretches cost two
+// evaluations per coarse interval; sharp features are followed down to
+// minStep.
+template <typename F, typename B = NoCurveBound>
+std::vector<CurvePoint> sampleCurve(F f, double x0, double x1, const CurveTolerance& tol, int coarse,
+                                    const B& bound = B()) {
+    std::vector<CurvePoint> out;
+    CurvePoint a = curvePoint(f, x0);
+    appendCurvePoint(out, a);
+    for (int i = 1; i <= coarse; i++) {
+        CurvePoint b = curvePoint(f, x0 + (x1 - x0) * i / coarse);
+        subdivideCurve(f, bound, tol, a, b, out);
+        a = b;
+    }
+    return out;
+}
+
+// ============================================================================
+// KURVA IMPLISIT - quadtree dengan pemangkasan interval
+// ============================================================================
+
+// One piece of an implicit curve, in world coordinates.
+struct CurveSegment {
+    double x0, y0, x1, y1;
+};
+
+// Marching squares on one cell: corner values v (bottom-left, bottom-right,
+// top-right, top-left) and the value at the centre to settle saddles.
+template <typename F>
+void implicitCell(F& f, double x0, double y0, double s, std::vector<CurveSegment>& out) {
+    const double cx[4] = {x0, x0 + s, x0 + s, x0};
+    const double cy[4] = {y0, y0, y0 + s, y0 + s};
+    double v[4];
+    for (int i = 0; i < 4; i++)
+        if (!f(cx[i], cy[i], v[i]) || !std::isfinite(v[i])) return;
+
+    // Crossing point on edge i (corner i to corner i + 1), if any.
+    double px[4], py[4];
+    bool cross[4];
+    int n = 0;
+    for (int i = 0; i < 4; i++) {
+        int j = (i + 1) % 4;
+        cross[i] = (v[i] < 0) != (v[j] < 0);
+        if (!cross[i]) continue;
+        double t = v[i] / (v[i] - v[j]);
+        px[i] = cx[i] + t * (cx[j] - cx[i]);
+        py[i] = cy[i] + t * (cy[j] - cy[i]);
+        n++;
+    }
+    auto segment = [&](int a, int b) { out.push_back({px[a], py[a], px[b], py[b]}); };
+    if (n == 2) {
+        int a = -1, b = -1;
+        for (int i = 0; i < 4; i++)
+            if (cross[i]) (a < 0 ? a : b) = i;
+        segment(a, b);
+    } else if (n == 4) {
+        double c;
+        if (!f(x0 + 0.5 * s, y0 + 0.5 * s, c) || !std::isfinite(c)) return;
+        // Edges: 0 bottom, 1 right, 2 top, 3 left. The corners that share
+        // the centre's sign are joined through it.
+        if ((c < 0) == (v[0] < 0)) {
+            segment(0, 1);
+            segment(2, 3);
+        } else {
+            segment(3, 0);
+            segment(1, 2);
+        }
+    }
+}
+
+template <typename F, typename B>
+void implicitQuad(F& f, const B& bound, double x0, double y0, double s, double leaf,
+                  const std::atomic<bool>* cancelled, std::vector<CurveSegment>& out) {
+    if (cancelled && *cancelled) return;
+    Interval v = bound(Interval{x0, x0 + s}, Interval{y0, y0 + s});
+    if (v.empty() || !v.contains(0)) return;
+    if (s <= leaf) {
+        // A sign change next to a pole is an asymptote, not the curve.
+        if (v.continuous) implicitCell(f, x0, y0, s, out);
+        return;
+    }
+    double h = 0.5 * s;
+    implicitQuad(f, bound, x0, y0, h, leaf, cancelled, out);
+    implicitQuad(f, bound, x0 + h, y0, h, leaf, cancelled, out);
+    implicitQuad(f, bound, x0, y0 + h, h, leaf, cancelled, out);
+    implicitQuad(f, bound, x0 + h, y0 + h, h, leaf, cancelled, out);
+}
+
+// Traces f(x, y) = 0 over the world box [x0, x1] x [y0, y1]. f(x, y, v)
+// stores the value in v and returns false where it is undefined;
+// bound(X, Y) encloses f over a box, e.g. via Parser::evalInterval. The box
+// is covered by cells of rootPx pixels; a cell whose enclosure excludes 0
+// is dropped, the rest split in four down to leafPx, so the work follows
+// the length of the curve rather than the area of the view. Once
+// *cancelled is set no further cell is visited and the segments found so
+// far are returned.
+template <typename F, typename B>
+std::vector<CurveSegment> traceImplicit(F f, const B& bound, double x0, double y0, double x1, double y1,
+                                        double pxPerUnit, const std::atomic<bool>* cancelled = nullptr,
+                                        double leafPx = 1, double rootPx = 64) {
+    std::vector<CurveSegment> out;
+    double leaf = leafPx / pxPerUnit;
+    double root = leaf;
+    while (root * pxPerUnit < rootPx) root *= 2;
+    for (double y = y0; y < y1; y += root)
+        for (double x = x0; x < x1; x += root)
+            implicitQuad(f, bound, x, y, root, leaf, cancelled, out);
+    return out;
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// ============================================================================
+// SIMD - kernel kolom dengan pemilihan ISA saat runtime
+// ============================================================================
+
+// One table per instruction set. Column kernels write d[i] = f(a[i]) or
+// d[i] = a[i] op b[i] and allow d to alias an operand; div clears ok[i]
+// where the divisor is zero, like the scalar evaluator.
+struct SimdKernels {
+    const char* isa;
+    void (*add)(double* d, const double* a, const double* b, size_t n);
+    void (*sub)(double* d, const double* a, const double* b, size_t n);
+    void (*mul)(double* d, const double* a, const double* b, size_t n);
+    void (*div)(double* d, const double* a, const double* b, uint8_t* ok, size_t n);
+    void (*pow)(double* d, const double* a, const double* b, size_t n);
+    void (*sin)(double* d, const double* a, size_t n);
+    void (*cos)(double* d, const double* a, size_t n);
+    void (*exp)(double* d, const double* a, size_t n);
+    void (*ln)(double* d, const double* a, size_t n);
+    void (*log10)(double* d, const double* a, size_t n);
+    void (*sqrt)(double* d, const double* a, size_t n);
+    void (*abs)(double* d, const double* a, size_t n);
+    void (*floor)(double* d, const double* a, size_t n);
+    void (*ceil)(double* d, const double* a, size_t n);
+    void (*tanh)(double* d, const double* a, size_t n);
+    void (*sinh)(double* d, const double* a, size_t n);
+    void (*cosh)(double* d, const double* a, size_t n);
+};
+
+// ----------------------------------------------------------------------------
+// Scalar lanes (fallback for non-x86 targets)
+// ----------------------------------------------------------------------------
+
+namespace simd_scalar {
+
+struct V {
+    typedef double T;
+    typedef bool M;
+    static const size_t W = 1;
+
+    static const char* name() { return "scalar"; }
+    static T load(const double* p) { return *p; }
+    static void store(double* p, T v) { *p = v; }
+    static T set(double v) { return v; }
+    static T add(T a, T b) { return a + b; }
+    static T sub(T a, T b) { return a - b; }
+    static T mul(T a, T b) { return a * b; }
+    static T div(T a, T b) { return a / b; }
+    static T fma(T a, T b, T c) { return a * b + c; }
+    static T neg(T a) { return -a; }
+    static T abs(T a) { return std::fabs(a); }
+    static T sqrt(T a) { return std::sqrt(a); }
+    static T floor(T a) { return std::floor(a); }
+    static M lt(T a, T b) { return a < b; }
+    static M le(T a, T b) { return a <= b; }
+    static M gt(T a, T b) { return a > b; }
+    static M ge(T a, T b) { return a >= b; }
+    static M eq(T a, T b) { return a == b; }
+    static M ne(T a, T b) { return !(a == b); }
+    static M and_(M a, M b) { return a && b; }
+    static bool all(M m) { return m; }
+    static int bits(M m) { return m ? 1 : 0; }
+    static T select(M m, T a, T b) { return m ? a : b; }
+    static T pow2i(T n) { return std::ldexp(1.0, int(std::fmax(-2000.0, std::fmin(2000.0, n)))); }
+    static T exponent(T x) { int e; std::frexp(x, &e); return e; }
+    static T mantissa(T x) { int e; return std::frexp(x, &e); }
+};
+
+#include "simd_kernels.inl"
+
+} // namespace simd_scalar
+
+#ifdef SIMD_X86
+
+// ----------------------------------------------------------------------------
+// SSE2 (baseline on x86-64)
+// ----------------------------------------------------------------------------
+
+namespace simd_sse2 {
+
+struct V {
+    typedef __m128d T;
+    typedef __m128d M;
+    static const size_t W = 2;
+
+    static const char* name() { return "sse2"; }
+    static T load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, T v) { _mm_storeu_pd(p, v); }
+    static T set(double v) { return _mm_set1_pd(v); }
+    static T add(T a, T b) { return _mm_add_pd(a, b); }
+    static T sub(T a, T b) { return _mm_sub_pd(a, b); }
+    static T mul(T a, T b) { return _mm_mul_pd(a, b); }
+    static T div(T a, T b) { return _mm_div_pd(a, b); }
+    static T fma(T a, T b, T c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static T neg(T a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+    static T abs(T a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    static T sqrt(T a) { return _mm_sqrt_pd(a); }
+    static M lt(T a, T b) { return _mm_cmplt_pd(a, b); }
+    static M le(T a, T b) { return _mm_cmple_pd(a, b); }
+    static M gt(T a, T b) { return _mm_cmpgt_pd(a, b); }
+    static M ge(T a, T b) { return _mm_cmpge_pd(a, b); }
+    static M eq(T a, T b) { return _mm_cmpeq_pd(a, b); }
+    static M ne(T a, T b) { return _mm_cmpneq_pd(a, b); }
+    static M and_(M a, M b) { return _mm_and_pd(a, b); }
+    static bool all(M m) { return _mm_movemask_pd(m) == 3; }
+    static int bits(M m) { return _mm_movemask_pd(m); }
+    static T select(M m, T a, T b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+
+    // No roundpd before SSE4.1: round via the 2^52 trick, then fix up.
+    static T floor(T x) {
+        T two52 = set(4503599627370496.0);
+        T ax = abs(x);
+        T r = _mm_sub_pd(_mm_add_pd(ax, two52), two52);
+        r = _mm_or_pd(r, _mm_and_pd(x, set(-0.0)));
+        r = _mm_sub_pd(r, _mm_and_pd(gt(r, x), set(1.0)));
+        return select(lt(ax, two52), r, x);
+    }
+
+    static T pow2i(T n) {
+        const T magic = set(6755399441055744.0);
+        __m128i i = _mm_sub_epi64(_mm_castpd_si128(_mm_add_pd(n, magic)), _mm_castpd_si128(magic));
+        i = _mm_slli_epi64(_mm_add_epi64(i, _mm_set1_epi64x(1023)), 52);
+        return _mm_castsi128_pd(i);
+    }
+
+    static T exponent(T x) {
+        const T magic = set(6755399441055744.0);
+        __m128i e = _mm_and_si128(_mm_srli_epi64(_mm_castpd_si128(x), 52), _mm_set1_epi64x(0x7ff));
+        T ed = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(e, _mm_castpd_si128(magic))), magic);
+        return _mm_sub_pd(ed, set(1022));
+    }
+
+    static T mantissa(T x) {
+        __m128i b = _mm_and_si128(_mm_castpd_si128(x), _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+        return _mm_castsi128_pd(_mm_or_si128(b, _mm_set1_epi64x(0x3FE0000000000000LL)));
+    }
+};
+
+#include "simd_kernels.inl"
+
+} // namespace simd_sse2
+
+// ----------------------------------------------------------------------------
+// AVX2 + FMA, compiled with a target pragma and only used when the CPU
+// reports support for both.
+// ----------------------------------------------------------------------------
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace simd_avx2 {
+
+struct V {
+    typedef __m256d T;
+    typedef __m256d M;
+    static const size_t W = 4;
+
+    static const char* name() { return "avx2"; }
+    static T load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, T v) { _mm256_storeu_pd(p, v); }
+    static T set(double v) { return _mm256_set1_pd(v); }
+    static T add(T a, T b) { return _mm256_add_pd(a, b); }
+    static T sub(T a, T b) { return _mm256_sub_pd(a, b); }
+    static T mul(T a, T b) { return _mm256_mul_pd(a, b); }
+    static T div(T a, T b) { return _mm256_div_pd(a, b); }
+    static T fma(T a, T b, T c) { return _mm256_fmadd_pd(a, b, c); }
+    static T neg(T a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+    static T abs(T a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static T sqrt(T a) { return _mm256_sqrt_pd(a); }
+    static T floor(T a) { return _mm256_floor_pd(a); }
+    static M lt(T a, T b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static M le(T a, T b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static M gt(T a, T b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static M ge(T a, T b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+    static M eq(T a, T b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static M ne(T a, T b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+    static M and_(M a, M b) { return _mm256_and_pd(a, b); }
+    static bool all(M m) { return _mm256_movemask_pd(m) == 15; }
+    static int bits(M m) { return _mm256_movemask_pd(m); }
+    static T select(M m, T a, T b) { return _mm256_blendv_pd(b, a, m); }
+
+    static T pow2i(T n) {
+        const T magic = set(6755399441055744.0);
+        __m256i i = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(n, magic)), _mm256_castpd_si256(magic));
+        i = _mm256_slli_epi64(_mm256_add_epi64(i, _mm256_set1_epi64x(1023)), 52);
+        return _mm256_castsi256_pd(i);
+    }
+
+    static T exponent(T x) {
+        const T magic = set(6755399441055744.0);
+        __m256i e = _mm256_and_si256(_mm256_srli_epi64(_mm256_castpd_si256(x), 52), _mm256_set1_epi64x(0x7ff));
+        T ed = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(e, _mm256_castpd_si256(magic))), magic);
+        return _mm256_sub_pd(ed, set(1022));
+    }
+
+    static T mantissa(T x) {
+        __m256i b = _mm256_and_si256(_mm256_castpd_si256(x), _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+        return _mm256_castsi256_pd(_mm256_or_si256(b, _mm256_set1_epi64x(0x3FE0000000000000LL)));
+    }
+};
+
+#include "simd_kernels.inl"
+
+} // namespace simd_avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // SIMD_X86
+
+// ----------------------------------------------------------------------------
+// Dispatch
+// ----------------------------------------------------------------------------
+
+inline bool cpuHasAvx2() {
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+// Picks the widest kernel set the running CPU supports, once.
+inline const SimdKernels& simdKernels() {
+#ifdef SIMD_X86
+    static const SimdKernels& k = cpuHasAvx2() ? simd_avx2::table() : simd_sse2::table();
+#else
+    static const SimdKernels& k = simd_scalar::table();
+#endif
+    return k;
+}
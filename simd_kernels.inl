@@ -0,0 +1,306 @@
+// Vector math kernels, written once against the lane interface `V` and
+// instantiated for every ISA by simd.hpp (included inside a namespace that
+// defines V). No #include here on purpose.
+//
+// Polynomials and range reduction follow Cephes (exp, log, sin/cos, tanh);
+// results agree with libm to a few ulp over the plotting range.
+// Lanes outside the safe reduction range fall back to the libm call.
+
+typedef V::T T;
+typedef V::M M;
+
+inline T k(double v) { return V::set(v); }
+
+inline T poly2(T x, double c0, double c1, double c2) {
+    return V::fma(V::fma(k(c0), x, k(c1)), x, k(c2));
+}
+
+inline T poly3(T x, double c0, double c1, double c2, double c3) {
+    return V::fma(poly2(x, c0, c1, c2), x, k(c3));
+}
+
+inline T poly5(T x, double c0, double c1, double c2, double c3, double c4, double c5) {
+    return V::fma(V::fma(poly3(x, c0, c1, c2, c3), x, k(c4)), x, k(c5));
+}
+
+inline T expV(T x) {
+    T n = V::floor(V::fma(x, k(1.4426950408889634073599), k(0.5)));
+    T r = V::sub(V::sub(x, V::mul(n, k(6.93145751953125E-1))), V::mul(n, k(1.42860682030941723212E-6)));
+    T xx = V::mul(r, r);
+    T px = V::mul(r, poly2(xx, 1.26177193074810590878E-4, 3.02994407707441961300E-2, 9.99999999999999999910E-1));
+    T qx = poly3(xx, 3.00198505138664455042E-6, 2.52448340349684104192E-3,
+                 2.27265548208155028766E-1, 2.00000000000000000009E0);
+    r = V::fma(V::div(px, V::sub(qx, px)), k(2), k(1));
+
+    // 2^n applied in two halves so n = 1024 and subnormal results still work
+    T h = V::floor(V::mul(n, k(0.5)));
+    r = V::mul(V::mul(r, V::pow2i(h)), V::pow2i(V::sub(n, h)));
+    r = V::select(V::gt(x, k(7.09782712893383996843E2)), k(HUGE_VAL), r);
+    r = V::select(V::lt(x, k(-7.451332191019411E2)), k(0), r);
+    return r;
+}
+
+inline T logV(T x) {
+    M tiny = V::lt(x, k(2.2250738585072014e-308));
+    T xs = V::select(tiny, V::mul(x, k(18014398509481984.0)), x);
+    T e = V::exponent(xs);
+    e = V::select(tiny, V::sub(e, k(54)), e);
+    T m = V::mantissa(xs);
+
+    M low = V::lt(m, k(0.70710678118654752440));
+    e = V::select(low, V::sub(e, k(1)), e);
+    m = V::select(low, V::sub(V::add(m, m), k(1)), V::sub(m, k(1)));
+
+    T z = V::mul(m, m);
+    T p = poly5(m, 1.01875663804580931796E-4, 4.97494994976747001425E-1, 4.70579119878881725854E0,
+                1.44989225341610930846E1, 1.79368678507819816313E1, 7.70838733755885391666E0);
+    T q = poly5(m, 1.0, 1.12873587189167450590E1, 4.52279145837532221105E1,
+                8.29875266912776603211E1, 7.11544750618563894466E1, 2.31251620126765340583E1);
+    T y = V::mul(m, V::div(V::mul(z, p), q));
+    y = V::fma(e, k(-2.121944400546905827679e-4), y);
+    y = V::fma(z, k(-0.5), y);
+    z = V::add(m, y);
+    z = V::fma(e, k(0.693359375), z);
+
+    z = V::select(V::eq(x, k(0)), k(-HUGE_VAL), z);
+    z = V::select(V::lt(x, k(0)), k(NAN), z);
+    z = V::select(V::eq(x, k(HUGE_VAL)), x, z);
+    z = V::select(V::ne(x, x), x, z);
+    return z;
+}
+
+// Shared octant reduction for sin/cos; returns z in [-pi/4, pi/4] and the
+// even octant index j in {0, 2, 4, 6}.
+inline T reduceOctant(T ax, T& j) {
+    j = V::floor(V::mul(ax, k(1.27323954473516268615)));
+    T half = V::floor(V::mul(j, k(0.5)));
+    M odd = V::ne(V::add(half, half), j);
+    j = V::select(odd, V::add(j, k(1)), j);
+    T z = V::sub(ax, V::mul(j, k(7.85398125648498535156E-1)));
+    z = V::sub(z, V::mul(j, k(3.77489470793079817668E-8)));
+    z = V::sub(z, V::mul(j, k(2.69515142907905952645E-15)));
+    j = V::sub(j, V::mul(V::floor(V::mul(j, k(0.125))), k(8)));
+    return z;
+}
+
+inline T sinPoly(T z, T zz) {
+    T p = poly5(zz, 1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6,
+                -1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1);
+    return V::fma(V::mul(z, zz), p, z);
+}
+
+inline T cosPoly(T zz) {
+    T p = poly5(zz, -1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7,
+                2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2);
+    return V::fma(V::mul(zz, zz), p, V::fma(zz, k(-0.5), k(1)));
+}
+
+inline T sinV(T x) {
+    T ax = V::abs(x), j;
+    T z = reduceOctant(ax, j);
+    M flip = V::gt(j, k(3));
+    j = V::select(flip, V::sub(j, k(4)), j);
+    T zz = V::mul(z, z);
+    T r = V::select(V::eq(j, k(2)), cosPoly(zz), sinPoly(z, zz));
+    T neg = V::select(V::lt(x, k(0)), k(-1), k(1));
+    return V::mul(r, V::select(flip, V::neg(neg), neg));
+}
+
+inline T cosV(T x) {
+    T ax = V::abs(x), j;
+    T z = reduceOctant(ax, j);
+    M flip = V::gt(j, k(3));
+    j = V::select(flip, V::sub(j, k(4)), j);
+    T sign = V::select(flip, k(-1), k(1));
+    sign = V::select(V::gt(j, k(1)), V::neg(sign), sign);
+    T zz = V::mul(z, z);
+    T r = V::select(V::eq(j, k(2)), sinPoly(z, zz), cosPoly(zz));
+    return V::mul(r, sign);
+}
+
+inline T tanhV(T x) {
+    T ax = V::abs(x);
+    T s = expV(V::add(ax, ax));
+    T big = V::sub(k(1), V::div(k(2), V::add(s, k(1))));
+    big = V::select(V::lt(x, k(0)), V::neg(big), big);
+    T z = V::mul(x, x);
+    T p = poly2(z, -9.64399179425052238628E-1, -9.92877231001918586564E1, -1.61468768441708447952E3);
+    T q = poly3(z, 1.0, 1.12811678491632931402E2, 2.23548839060100448583E3, 4.84406305325125486048E3);
+    T small = V::fma(V::mul(x, z), V::div(p, q), x);
+    return V::select(V::ge(ax, k(0.625)), big, small);
+}
+
+// sinh/cosh via exp(|x|); callers send |x| > 709 to libm, where exp
+// overflows before the result does. Small |x| uses 2t/(1-t^2) with
+// t = tanh(x/2) to avoid the cancellation in e - 1/e.
+inline T sinhV(T x) {
+    T e = expV(V::abs(x));
+    T big = V::fma(e, k(0.5), V::neg(V::div(k(0.5), e)));
+    big = V::select(V::lt(x, k(0)), V::neg(big), big);
+    T t = tanhV(V::mul(x, k(0.5)));
+    T small = V::div(V::add(t, t), V::fma(V::neg(t), t, k(1)));
+    return V::select(V::gt(V::abs(x), k(1)), big, small);
+}
+
+inline T coshV(T x) {
+    T e = expV(V::abs(x));
+    return V::fma(e, k(0.5), V::div(k(0.5), e));
+}
+
+// pow: small integral exponents by repeated squaring, positive bases via
+// exp(b*ln a); everything else is left to libm by the caller.
+inline T powIntV(T a, T b) {
+    T nb = V::abs(b);
+    T r = k(1), base = a;
+    for (int bit = 0; bit < 7; bit++) {
+        T half = V::floor(V::mul(nb, k(0.5)));
+        M odd = V::ne(V::add(half, half), nb);
+        r = V::select(odd, V::mul(r, base), r);
+        base = V::mul(base, base);
+        nb = half;
+    }
+    return V::select(V::lt(b, k(0)), V::div(k(1), r), r);
+}
+
+// ----------------------------------------------------------------------------
+// Column loops
+// ----------------------------------------------------------------------------
+
+typedef T (*LaneFn)(T);
+
+// Applies f to full vectors; the tail is padded into a temporary vector.
+// d may alias a.
+template <LaneFn f>
+inline void mapColumn(double* d, const double* a, size_t n) {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W)
+        V::store(d + i, f(V::load(a + i)));
+    if (i < n) {
+        double tmp[V::W];
+        for (size_t l = 0; l < V::W; l++) tmp[l] = i + l < n ? a[i + l] : 1.0;
+        V::store(tmp, f(V::load(tmp)));
+        for (size_t l = 0; i + l < n; l++) d[i + l] = tmp[l];
+    }
+}
+
+// Same, but vectors with a lane whose |x| exceeds `limit` (or is not
+// finite) are handed to the libm function, as is the tail.
+template <LaneFn f, double (*libm)(double)>
+inline void mapColumnLimited(double* d, const double* a, size_t n, double limit) {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W) {
+        T x = V::load(a + i);
+        if (V::all(V::le(V::abs(x), k(limit))))
+            V::store(d + i, f(x));
+        else
+            for (size_t l = 0; l < V::W; l++) d[i + l] = libm(a[i + l]);
+    }
+    for (; i < n; i++) d[i] = libm(a[i]);
+}
+
+// Binary kernels compute d = a op b; d may alias either operand.
+inline void colAdd(double* d, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W) V::store(d + i, V::add(V::load(a + i), V::load(b + i)));
+    for (; i < n; i++) d[i] = a[i] + b[i];
+}
+
+inline void colSub(double* d, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W) V::store(d + i, V::sub(V::load(a + i), V::load(b + i)));
+    for (; i < n; i++) d[i] = a[i] - b[i];
+}
+
+inline void colMul(double* d, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W) V::store(d + i, V::mul(V::load(a + i), V::load(b + i)));
+    for (; i < n; i++) d[i] = a[i] * b[i];
+}
+
+inline void colDiv(double* d, const double* a, const double* b, uint8_t* ok, size_t n) {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W) {
+        T den = V::load(b + i);
+        M nz = V::ne(den, k(0));
+        V::store(d + i, V::select(nz, V::div(V::load(a + i), den), k(0)));
+        int bits = V::bits(nz);
+        for (size_t l = 0; l < V::W; l++) ok[i + l] &= (bits >> l) & 1;
+    }
+    for (; i < n; i++) {
+        double den = b[i];
+        ok[i] &= den != 0;
+        d[i] = den != 0 ? a[i] / den : 0;
+    }
+}
+
+// One vector of a^b; vectors that miss both fast paths go through libm.
+inline T powLane(T a, T b) {
+    M finite = V::and_(V::le(V::abs(a), k(1.79e308)), V::le(V::abs(b), k(1.79e308)));
+    M integral = V::and_(V::eq(V::floor(b), b), V::le(V::abs(b), k(64)));
+    if (V::all(V::and_(finite, integral)))
+        return powIntV(a, b);
+    if (V::all(V::and_(finite, V::gt(a, k(0)))))
+        return expV(V::mul(b, logV(a)));
+    double ta[V::W], tb[V::W];
+    V::store(ta, a);
+    V::store(tb, b);
+    for (size_t l = 0; l < V::W; l++) ta[l] = ::pow(ta[l], tb[l]);
+    return V::load(ta);
+}
+
+inline void colPow(double* d, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W) V::store(d + i, powLane(V::load(a + i), V::load(b + i)));
+    for (; i < n; i++) d[i] = ::pow(a[i], b[i]);
+}
+
+inline T sqrtL(T x) { return V::sqrt(x); }
+inline T absL(T x) { return V::abs(x); }
+inline T floorL(T x) { return V::floor(x); }
+inline T ceilL(T x) { return V::neg(V::floor(V::neg(x))); }
+inline T log10L(T x) { return V::mul(logV(x), k(0.43429448190325182765)); }
+inline double libmSin(double x) { return ::sin(x); }
+inline double libmCos(double x) { return ::cos(x); }
+inline double libmSinh(double x) { return ::sinh(x); }
+inline double libmCosh(double x) { return ::cosh(x); }
+
+inline void colSqrt(double* d, const double* a, size_t n)  { mapColumn<sqrtL>(d, a, n); }
+inline void colAbs(double* d, const double* a, size_t n)   { mapColumn<absL>(d, a, n); }
+inline void colFloor(double* d, const double* a, size_t n) { mapColumn<floorL>(d, a, n); }
+inline void colCeil(double* d, const double* a, size_t n)  { mapColumn<ceilL>(d, a, n); }
+inline void colExp(double* d, const double* a, size_t n)   { mapColumn<expV>(d, a, n); }
+inline void colLn(double* d, const double* a, size_t n)    { mapColumn<logV>(d, a, n); }
+inline void colLog10(double* d, const double* a, size_t n) { mapColumn<log10L>(d, a, n); }
+inline void colTanh(double* d, const double* a, size_t n)  { mapColumn<tanhV>(d, a, n); }
+inline void colSinh(double* d, const double* a, size_t n)  { mapColumnLimited<sinhV, libmSinh>(d, a, n, 709); }
+inline void colCosh(double* d, const double* a, size_t n)  { mapColumnLimited<coshV, libmCosh>(d, a, n, 709); }
+inline void colSin(double* d, const double* a, size_t n)   { mapColumnLimited<sinV, libmSin>(d, a, n, 1e6); }
+inline void colCos(double* d, const double* a, size_t n)   { mapColumnLimited<cosV, libmCos>(d, a, n, 1e6); }
+
+// ----------------------------------------------------------------------------
+// Whole-vector entry points, one call per vector (used by jit.hpp)
+// ----------------------------------------------------------------------------
+
+template <LaneFn f, double (*libm)(double), int limit>
+inline T limitedLane(T x) {
+    if (V::all(V::le(V::abs(x), k(limit)))) return f(x);
+    double t[V::W];
+    V::store(t, x);
+    for (size_t l = 0; l < V::W; l++) t[l] = libm(t[l]);
+    return V::load(t);
+}
+
+inline T sinLane(T x)  { return limitedLane<sinV, libmSin, 1000000>(x); }
+inline T cosLane(T x)  { return limitedLane<cosV, libmCos, 1000000>(x); }
+inline T sinhLane(T x) { return limitedLane<sinhV, libmSinh, 709>(x); }
+inline T coshLane(T x) { return limitedLane<coshV, libmCosh, 709>(x); }
+
+inline const SimdKernels& table() {
+    static const SimdKernels t = {
+        V::name(),
+        colAdd, colSub, colMul, colDiv, colPow,
+        colSin, colCos, colExp, colLn, colLog10, colSqrt, colAbs,
+        colFloor, colCeil, colTanh, colSinh, colCosh
+    };
+    return t;
+}
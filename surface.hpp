@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// TESELASI ADAPTIF - quadtree terbatas di atas lattice
+// ============================================================================
+
+// Surfaces z = f(x, y) are drawn in a world box of [-GRID_RANGE,
+// GRID_RANGE] in x and y. Quadtree cells live on a lattice of GRID_MAX
+// cells per axis over that box; the coarsest cell is GRID_ROOT lattice
+// cells wide. Shared by the 3D grapher and the headless renderer.
+const float GRID_RANGE = 3.5f;
+const int GRID_MAX = 256;
+const int GRID_ROOT = 32;
+
+// Leaf of a surface quadtree: lattice cell (i, j) of size lattice cells.
+// Bit k of finer / same is set when the neighbour across side k (0 bottom,
+// 1 right, 2 top, 3 left) is split finer / the same size. Neighbours
+// differ by at most one level, so a finer side has exactly one extra
+// vertex at its midpoint.
+struct SurfaceLeaf {
+    int i, j, size;
+    uint8_t finer, same;
+};
+
+// Samples and tessellation of one surface z = f(x, y). Lattice points are
+// evaluated on demand (z and, where the caller wants it, the exact
+// gradient) and kept, so re-tessellating for a different tolerance only
+// evaluates points it has not seen.
+struct SurfaceMesh {
+    std::vector<double> z, dx, dy;
+    std::vector<uint8_t> ok, sampled;
+    std::vector<float> zf;  // z narrowed for projection
+    size_t samples = 0;
+
+    float tolerance = 0;  // world units the leaves were built for; 0 = none
+    std::vector<SurfaceLeaf> leaves;
+
+    void reserveLattice() {
+        if (!z.empty()) return;
+        size_t n = size_t(GRID_MAX + 1) * (GRID_MAX + 1);
+        z.resize(n);
+        dx.resize(n);
+        dy.resize(n);
+        ok.resize(n);
+        sampled.resize(n);
+        zf.resize(n);
+    }
+};
+
+inline int latticeIndex(int i, int j) { return i * (GRID_MAX + 1) + j; }
+inline float latticeCoord(int i) { return -GRID_RANGE + i * (2 * GRID_RANGE / GRID_MAX); }
+
+// Drawable sample: defined, finite and inside the plotted z range.
+inline bool latticeUsable(const SurfaceMesh& m, int k) {
+    return m.ok[k] && std::isfinite(m.z[k]) && std::fabs(m.z[k]) < 10;
+}
+
+// Whether cell c must be split: it straddles a domain or clipping edge,
+// or a midpoint of its edges or its centre deviates from the bilinear
+// patch through its corners by more than tol. Cells with nothing
+// drawable are left alone.
+inline bool surfaceCellRough(const SurfaceMesh& m, const SurfaceLeaf& c, float tol) {
+    int s = c.size, h = s / 2;
+    int a = latticeIndex(c.i, c.j), b = latticeIndex(c.i + s, c.j);
+    int cc = latticeIndex(c.i + s, c.j + s), d = latticeIndex(c.i, c.j + s);
+    int pts[9] = {a, b, cc, d, latticeIndex(c.i + h, c.j), latticeIndex(c.i + s, c.j + h),
+                  latticeIndex(c.i + h, c.j + s), latticeIndex(c.i, c.j + h), latticeIndex(c.i + h, c.j + h)};
+    int usable = 0;
+    for (int k : pts) usable += latticeUsable(m, k);
+    if (usable == 0) return false;
+    if (usable < 9) return true;
+    const std::vector<double>& z = m.z;
+    double err = std::max({std::fabs(z[pts[4]] - 0.5 * (z[a] + z[b])),
+                           std::fabs(z[pts[5]] - 0.5 * (z[b] + z[cc])),
+                           std::fabs(z[pts[6]] - 0.5 * (z[cc] + z[d])),
+                           std::fabs(z[pts[7]] - 0.5 * (z[d] + z[a])),
+                           std::fabs(z[pts[8]] - 0.25 * (z[a] + z[b] + z[cc] + z[d]))});
+    return err > tol;
+}
+
+// Rebuilds m.leaves for tolerance tol (world units). Refinement runs level
+// by level so each level's new lattice points go to sample(points) as one
+// batch; sample must evaluate them and set m.sampled. Afterwards cells are
+// split until neighbouring leaves differ by at most one level, which
+// leaves at most one T-junction per side for the triangulation to close.
+// Returns false if cancelled part way.
+template <typename Sample>
+bool tessellateSurface(SurfaceMesh& m, float tol, Sample sample, const std::atomic<bool>& cancelled) {
+    const int N = GRID_MAX;
+    m.reserveLattice();
+    std::vector<int> pending;
+    auto need = [&](int i, int j) {
+        int k = latticeIndex(i, j);
+        if (!m.sampled[k]) pending.push_back(k);
+    };
+    auto flush = [&] {
+        std::sort(pending.begin(), pending.end());
+        pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+        if (!pending.empty()) sample(pending);
+        pending.clear();
+        return !cancelled;
+    };
+    // Points a cell's split test and children need.
+    auto needSplit = [&](const SurfaceLeaf& c) {
+        int s = c.size, h = s / 2;
+        need(c.i + h, c.j);
+        need(c.i + s, c.j + h);
+        need(c.i + h, c.j + s);
+        need(c.i, c.j + h);
+        need(c.i + h, c.j + h);
+    };
+    auto split = [](const SurfaceLeaf& c, std::vector<SurfaceLeaf>& out) {
+        int h = c.size / 2;
+        out.push_back({c.i, c.j, h, 0, 0});
+        out.push_back({c.i + h, c.j, h, 0, 0});
+        out.push_back({c.i, c.j + h, h, 0, 0});
+        out.push_back({c.i + h, c.j + h, h, 0, 0});
+    };
+
+    std::vector<SurfaceLeaf> cells, next, leaves;
+    for (int i = 0; i <= N; i += GRID_ROOT)
+        for (int j = 0; j <= N; j += GRID_ROOT) {
+            need(i, j);
+            if (i < N && j < N) cells.push_back({i, j, GRID_ROOT, 0, 0});
+        }
+    if (!flush()) return false;
+    while (!cells.empty()) {
+        for (auto& c : cells)
+            if (c.size > 1) needSplit(c);
+        if (!flush()) return false;
+        next.clear();
+        for (auto& c : cells) {
+            if (c.size > 1 && surfaceCellRough(m, c, tol)) split(c, next);
+            else leaves.push_back(c);
+        }
+        cells.swap(next);
+    }
+
+    // Size of the leaf covering every finest cell, to find neighbours.
+    std::vector<uint16_t> cover(size_t(N) * N);
+    auto paint = [&](const SurfaceLeaf& c) {
+        for (int a = 0; a < c.size; a++)
+            std::fill_n(&cover[size_t(c.i + a) * N + c.j], c.size, uint16_t(c.size));
+    };
+    // Smallest leaf across side k of c, or 0 at the domain border.
+    auto across = [&](const SurfaceLeaf& c, int k) {
+        int smallest = N;
+        for (int t = 0; t < c.size; t++) {
+            int i = k == 1 ? c.i + c.size : k == 3 ? c.i - 1 : c.i + t;
+            int j = k == 0 ? c.j - 1 : k == 2 ? c.j + c.size : c.j + t;
+            if (i < 0 || j < 0 || i >= N || j >= N) return 0;
+            smallest = std::min<int>(smallest, cover[size_t(i) * N + j]);
+        }
+        return smallest;
+    };
+    for (auto& c : leaves) paint(c);
+    for (;;) {
+        std::vector<SurfaceLeaf> keep, coarse;
+        for (auto& c : leaves) {
+            bool unbalanced = false;
+            for (int k = 0; k < 4 && !unbalanced; k++) {
+                int n = across(c, k);
+                unbalanced = n > 0 && n < c.size / 2;
+            }
+            (unbalanced ? coarse : keep).push_back(c);
+        }
+        if (coarse.empty()) break;
+        for (auto& c : coarse) needSplit(c);
+        if (!flush()) return false;
+        size_t first = keep.size();
+        for (auto& c : coarse) split(c, keep);
+        for (size_t k = first; k < keep.size(); k++) paint(keep[k]);
+        leaves.swap(keep);
+    }
+    // Leaves made by balancing were never tested, so their midpoints and
+    // centre may still be missing where the triangulation needs them.
+    for (auto& c : leaves) {
+        for (int k = 0; k < 4; k++) {
+            int n = across(c, k);
+            if (n > 0 && n < c.size) c.finer |= 1 << k;
+            if (n == c.size) c.same |= 1 << k;
+        }
+        if (c.finer) needSplit(c);
+    }
+    if (!flush()) return false;
+    m.leaves.swap(leaves);
+    m.tolerance = tol;
+    return true;
+}
+
+// Whether leaf c draws its side k in the wireframe. A side next to finer
+// leaves is drawn by those finer leaves, and between equal leaves by the
+// one it is the bottom or left side of, so every piece is drawn once.
+inline bool leafDrawsSide(const SurfaceLeaf& c, int k) {
+    return !(c.finer & (1 << k)) && !((c.same & (1 << k)) && (k == 1 || k == 2));
+}
+
+// Chains the wireframe sides of m's leaves into line strips and calls
+// strip(points, n) with the n lattice points of each. Every side lies on
+// a lattice row or column, so sides that touch end to end along one are
+// joined, and each lattice point appears about once per direction rather
+// than once per side.
+template <typename Strip>
+void wireframeStrips(const SurfaceMesh& m, Strip strip) {
+    const int N = GRID_MAX;
+    // next[d][a] = far end of the drawn side starting at a, along i (d = 0)
+    // or j (d = 1), or -1.
+    thread_local std::vector<int> next[2];
+    thread_local std::vector<int> points;
+    for (auto& v : next) v.assign(size_t(N + 1) * (N + 1), -1);
+    for (const SurfaceLeaf& c : m.leaves) {
+        int s = c.size;
+        const int corner[4] = {latticeIndex(c.i, c.j), latticeIndex(c.i + s, c.j),
+                               latticeIndex(c.i + s, c.j + s), latticeIndex(c.i, c.j + s)};
+        for (int k = 0; k < 4; k++) {
+            int a = corner[k], b = corner[(k + 1) % 4];
+            if (!leafDrawsSide(c, k) || !latticeUsable(m, a) || !latticeUsable(m, b)) continue;
+            next[k % 2][std::min(a, b)] = std::max(a, b);
+        }
+    }
+    for (int d = 0; d < 2; d++)
+        for (int line = 0; line <= N; line++)
+            for (int t = 0; t <= N; t++) {
+                int k = d == 0 ? latticeIndex(t, line) : latticeIndex(line, t);
+                if (next[d][k] < 0) continue;
+                points.assign(1, k);
+                for (; next[d][k] >= 0; k = next[d][k]) points.push_back(next[d][k]);
+                strip(points.data(), points.size());
+                t = d == 0 ? k / (N + 1) : k % (N + 1);
+            }
+}
@@ -1,7 +1,7 @@
 // SFML Function Grapher — minimal "like Desmos" experience
 // Features: type function in the top text box (e.g., sin(x), x^2+2*x+1, exp(-x^2)),
 // pan with left-drag, zoom with mouse wheel, reset view button, grid & axes.
-// Single-file, no extra deps beyond SFML. Expression parser supports + - * / ^,
+// No extra deps beyond SFML. The expression compiler (parser.hpp) supports + - * / ^,
 // parentheses, unary minus, and functions: sin, cos, tan, asin, acos, atan,
 // sinh, cosh, tanh, exp, ln (natural log), log (base 10), sqrt, abs, floor, ceil.
 
@@ -10,183 +10,14 @@
 #include <cctype>
 #include <string>
 #include <vector>
-#include <stack>
-#include <map>
 #include <functional>
 #include <sstream>
 #include <iomanip>
 #include <limits>
 #include <algorithm>
 
-// ---------------- Expression Parser (Shunting-yard to RPN) -----------------
-struct Token {
-    enum Type { NUMBER, VAR, OP, FUNC, LPAREN, RPAREN, COMMA } type;
-    double value{};          // for numbers
-    std::string text;        // for ops/func names
-    int precedence{};        // for ops
-    bool rightAssoc{};       // for ops
-    int arity{1};            // for functions (currently all unary)
-};
-
-static bool isIdentStart(char c){ return std::isalpha((unsigned char)c) || c=='_'; }
-static bool isIdentChar(char c){ return std::isalnum((unsigned char)c) || c=='_'; }
-
-struct Parser {
-    std::map<std::string, std::function<double(double)>> funcs1;
-    std::map<std::string, std::function<double(double,double)>> funcs2; // reserved
-
-    Parser(){
-        using std::sin; using std::cos; using std::tan; using std::asin; using std::acos; using std::atan;
-        using std::sinh; using std::cosh; using std::tanh; using std::exp; using std::log; using std::sqrt; using std::fabs; using std::floor; using std::ceil;
-        funcs1 = {
-            {"sin", [](double x){ return sin(x); }},
-            {"cos", [](double x){ return cos(x); }},
-            {"tan", [](double x){ return tan(x); }},
-            {"asin", [](double x){ return asin(x); }},
-            {"acos", [](double x){ return acos(x); }},
-            {"atan", [](double x){ return atan(x); }},
-            {"sinh", [](double x){ return sinh(x); }},
-            {"cosh", [](double x){ return cosh(x); }},
-            {"tanh", [](double x){ return tanh(x); }},
-            {"exp", [](double x){ return exp(x); }},
-            {"ln",  [](double x){ return log(x); }},
-            {"log", [](double x){ return std::log10(x); }},
-            {"sqrt",[](double x){ return sqrt(x); }},
-            {"abs", [](double x){ return fabs(x); }},
-            {"floor",[](double x){ return floor(x); }},
-            {"ceil", [](double x){ return ceil(x); }}
-        };
-    }
-
-    std::vector<Token> tokenize(const std::string& s, std::string& err){
-        std::vector<Token> out; err.clear();
-        for(size_t i=0;i<s.size();){
-            char c = s[i];
-            if(std::isspace((unsigned char)c)){ ++i; continue; }
-            if(std::isdigit((unsigned char)c) || (c=='.' && i+1<s.size() && std::isdigit((unsigned char)s[i+1]))){
-                size_t j=i; bool hasE=false; bool hasDot=false; if(c=='.') hasDot=true;
-                while(j<s.size()){
-                    char d=s[j];
-                    if(std::isdigit((unsigned char)d)){ j++; }
-                    else if(d=='.' && !hasDot){ hasDot=true; j++; }
-                    else if((d=='e'||d=='E')&&!hasE){ hasE=true; j++; if(j<s.size() && (s[j]=='+'||s[j]=='-')) j++; }
-                    else break;
-                }
-                double val = std::strtod(s.c_str()+i,nullptr);
-                out.push_back({Token::NUMBER,val});
-                i=j; continue;
-            }
-            if(isIdentStart(c)){
-                size_t j=i+1; while(j<s.size() && isIdentChar(s[j])) j++;
-                std::string id = s.substr(i,j-i);
-                if(id=="x" || id=="X") out.push_back({Token::VAR});
-                else out.push_back({Token::FUNC,0,id});
-                i=j; continue;
-            }
-            if(c=='('){ out.push_back({Token::LPAREN}); i++; continue; }
-            if(c==')'){ out.push_back({Token::RPAREN}); i++; continue; }
-            if(c==','){ out.push_back({Token::COMMA}); i++; continue; }
-            // operators
-            if(std::string("+-*/^{}").find(c)!=std::string::npos){
-                std::string op(1,c);
-                int prec = (c=='+'||c=='-')?1:(c=='*'||c=='/')?2:(c=='^')?3:0;
-                bool right = (c=='^');
-                out.push_back({Token::OP,0,op,prec,right});
-                i++; continue;
-            }
-            err = std::string("Unknown char: ") + c; return {};
-        }
-        // Handle unary minus by inserting 0 before leading '-' or '(-' situations
-        std::vector<Token> fixed; fixed.reserve(out.size()*2);
-        for(size_t i=0;i<out.size();++i){
-            Token t = out[i];
-            if(t.type==Token::OP && t.text=="-"){
-                bool unary = (i==0) || (out[i-1].type==Token::OP || out[i-1].type==Token::LPAREN || out[i-1].type==Token::COMMA);
-                if(unary){
-                    fixed.push_back({Token::NUMBER,0.0});
-                }
-            }
-            fixed.push_back(t);
-        }
-        return fixed;
-    }
-
-    std::vector<Token> toRPN(const std::vector<Token>& tokens, std::string& err){
-        std::vector<Token> out; std::vector<Token> st; err.clear();
-        for(size_t i=0;i<tokens.size();++i){
-            const Token& t = tokens[i];
-            switch(t.type){
-                case Token::NUMBER: case Token::VAR: out.push_back(t); break;
-                case Token::FUNC: st.push_back(t); break;
-                case Token::COMMA:
-                    while(!st.empty() && st.back().type!=Token::LPAREN){ out.push_back(st.back()); st.pop_back(); }
-                    if(st.empty()){ err="Misplaced comma"; return {}; }
-                    break;
-                case Token::OP:
-                    while(!st.empty() && st.back().type==Token::OP &&
-                          ((t.rightAssoc==false && t.precedence<=st.back().precedence) ||
-                           (t.rightAssoc==true && t.precedence< st.back().precedence))){
-                        out.push_back(st.back()); st.pop_back();
-                    }
-                    st.push_back(t); break;
-                case Token::LPAREN: st.push_back(t); break;
-                case Token::RPAREN:
-                    while(!st.empty() && st.back().type!=Token::LPAREN){ out.push_back(st.back()); st.pop_back(); }
-                    if(st.empty()){ err="Mismatched parentheses"; return {}; }
-                    st.pop_back(); // remove LPAREN
-                    if(!st.empty() && st.back().type==Token::FUNC){ out.push_back(st.back()); st.pop_back(); }
-                    break;
-            }
-        }
-        while(!st.empty()){
-            if(st.back().type==Token::LPAREN || st.back().type==Token::RPAREN){ err="Mismatched parentheses"; return {}; }
-            out.push_back(st.back()); st.pop_back();
-        }
-        return out;
-    }
-
-    bool compile(const std::string& expr, std::vector<Token>& rpn, std::string& err){
-        auto toks = tokenize(expr, err);
-        if(!err.empty()) return false;
-        rpn = toRPN(toks, err);
-        return err.empty();
-    }
-
-    double eval(const std::vector<Token>& rpn, double x, bool& ok){
-        ok = true; std::vector<double> st; st.reserve(32);
-        for(const auto& t : rpn){
-            switch(t.type){
-                case Token::NUMBER: st.push_back(t.value); break;
-                case Token::VAR: st.push_back(x); break;
-                case Token::OP: {
-                    if(st.size()<2){ ok=false; return NAN; }
-                    double b=st.back(); st.pop_back();
-                    double a=st.back(); st.pop_back();
-                    double r = 0;
-                    if(t.text=="+") r=a+b;
-                    else if(t.text=="-") r=a-b;
-                    else if(t.text=="*") r=a*b;
-                    else if(t.text=="/") r=a/b;
-                    else if(t.text=="^") r=std::pow(a,b);
-                    else { ok=false; return NAN; }
-                    st.push_back(r);
-                } break;
-                case Token::FUNC: {
-                    // only unary for now
-                    if(st.empty()){ ok=false; return NAN; }
-                    double a=st.back(); st.pop_back();
-                    auto it = funcs1.find(t.text);
-                    if(it==funcs1.end()){ ok=false; return NAN; }
-                    double r = it->second(a);
-                    st.push_back(r);
-                } break;
-                default: ok=false; return NAN;
-            }
-        }
-        if(st.size()!=1){ ok=false; return NAN; }
-        return st.back();
-    }
-};
+#include "parser.hpp"
+#include "samples.hpp"
 
 // ---------------- Graphing Utilities -----------------
 struct ViewState {
@@ -351,12 +182,15 @@ int main(){
     Button helpBtn; helpBtn.init(font, "Bantuan", {840, 12}, {100, 36});
 
     // Parser & expression
-    Parser parser; std::vector<Token> rpn; std::string parseErr;
+    Parser parser; Program prog; std::string parseErr;
+    ColumnSamples samples; // per-column ring, reused across pans
     auto compileExpr = [&](const std::string& expr){
         parseErr.clear();
-        if(expr.empty()){ rpn.clear(); return; }
-        if(!parser.compile(expr, rpn, parseErr)){
-            rpn.clear();
+        samples.invalidate();
+        if(expr.empty()){ prog.clear(); return; }
+        if(!parser.compile(expr, prog, parseErr) || prog.usesY){
+            if(parseErr.empty()) parseErr = "Variable y is not supported";
+            prog.clear();
         }
     };
     compileExpr(input.content);
@@ -427,33 +261,41 @@ int main(){
         drawGrid(window, view, window.getSize());
 
         // Plot function if compiled
-        if(!rpn.empty()){
+        if(!prog.empty()){
             const int W = (int)window.getSize().x;
             sf::VertexArray strip(sf::LineStrip);
             strip.resize(W);
-            bool okPrev=false; double yPrev=0; bool havePrev=false;
+            bool okPrev=false; bool havePrev=false;
+            bool blockSmooth=false; const int BLOCK=16; // interval pole test per block of columns
             std::vector<sf::VertexArray> segments; segments.reserve(16);
             sf::VertexArray current(sf::LineStrip);
 
+            samples.update(view.origin.x, view.scale, W, [&](const double* xs, double* ys, uint8_t* ok, size_t n){
+                parser.evalBatch(prog, xs, ys, ok, n);
+            });
+
             for(int px=0; px<W; ++px){
-                sf::Vector2f world = screenToWorld(view, {(float)px, view.origin.y});
-                double x = world.x;
-                bool ok=true; double y = parser.eval(rpn, x, ok);
+                if(px % BLOCK == 0){
+                    Interval v = parser.evalInterval(prog, {samples.x(std::max(px-1, 0)), samples.x(std::min(px+BLOCK, W-1))});
+                    blockSmooth = v.defined && v.continuous;
+                }
+                double x = samples.x(px);
+                bool ok=samples.ok(px); double y = samples.y(px);
                 sf::Vector2f scr = worldToScreen(view, {(float)x, (float)y});
 
                 if(!ok || std::isnan(y) || std::isinf(y)){
                     if(current.getVertexCount()>=2) segments.push_back(current);
                     current.clear(); havePrev=false; okPrev=false; continue;
                 }
-                if(havePrev){
-                    double dy = std::abs(y - yPrev);
-                    if(dy * view.scale > 3000) { // large jump => break segment
+                if(havePrev && !blockSmooth){
+                    // pole or jump between the two columns => break segment
+                    if(!parser.evalInterval(prog, {samples.x(px-1), x}).continuous){
                         if(current.getVertexCount()>=2) segments.push_back(current);
                         current.clear(); havePrev=false; okPrev=false;
                     }
                 }
                 current.append(sf::Vertex(scr, sf::Color(50,90,200)));
-                yPrev=y; havePrev=true; okPrev=ok;
+                havePrev=true; okPrev=ok;
             }
             if(current.getVertexCount()>=2) segments.push_back(current);
             for(auto& seg: segments) window.draw(seg);
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "raster.hpp"
+
+// ============================================================================
+// SIMPLIFIKASI - Ramer-Douglas-Peucker dan penyambungan segmen
+// ============================================================================
+
+// Drops the points of a polyline that lie within tolerance (same units as
+// the points, normally px) of the simplified path. The first and last
+// points are always kept. Distances are measured to the chord segment,
+// not its line, so a curve that doubles back keeps its turning point.
+inline std::vector<PathPoint> simplifyPolyline(const std::vector<PathPoint>& pts, double tolerance) {
+    size_t n = pts.size();
+    if (n < 3) return pts;
+    auto distance = [](const PathPoint& p, const PathPoint& a, const PathPoint& b) {
+        double dx = b.x - a.x, dy = b.y - a.y, len2 = dx * dx + dy * dy;
+        double t = len2 > 0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2 : 0;
+        t = std::min(std::max(t, 0.0), 1.0);
+        return std::hypot(p.x - (a.x + t * dx), p.y - (a.y + t * dy));
+    };
+    std::vector<uint8_t> keep(n, 0);
+    keep[0] = keep[n - 1] = 1;
+    // Explicit stack: a curve sampled down to minStep can be deep.
+    std::vector<std::pair<size_t, size_t>> stack = {{0, n - 1}};
+    while (!stack.empty()) {
+        size_t a = stack.back().first, b = stack.back().second;
+        stack.pop_back();
+        double worst = tolerance;
+        size_t split = 0;
+        for (size_t i = a + 1; i < b; i++) {
+            double d = distance(pts[i], pts[a], pts[b]);
+            if (d > worst) {
+                worst = d;
+                split = i;
+            }
+        }
+        if (!split) continue;
+        keep[split] = 1;
+        stack.push_back({a, split});
+        stack.push_back({split, b});
+    }
+    std::vector<PathPoint> out;
+    for (size_t i = 0; i < n; i++)
+        if (keep[i]) out.push_back(pts[i]);
+    return out;
+}
+
+// Joins loose segments, given as consecutive endpoint pairs (e.g. the cells
+// of an implicit curve), into polylines wherever endpoints coincide to
+// within 1/1024 px.
+inline std::vector<std::vector<PathPoint>> joinSegments(const std::vector<PathPoint>& ends) {
+    size_t n = ends.size() / 2;
+    auto key = [](const PathPoint& p) {
+        return uint64_t(std::llround(p.x * 1024)) * 0x9E3779B97F4A7C15ull ^ uint64_t(std::llround(p.y * 1024));
+    };
+    // Endpoint key to endpoint indices (2 * segment + side).
+    std::unordered_multimap<uint64_t, size_t> at;
+    for (size_t i = 0; i < 2 * n; i++) at.emplace(key(ends[i]), i);
+    std::vector<uint8_t> used(n, 0);
+    auto extend = [&](std::vector<PathPoint>& path) {
+        for (;;) {
+            auto range = at.equal_range(key(path.back()));
+            size_t next = SIZE_MAX;
+            for (auto it = range.first; it != range.second && next == SIZE_MAX; ++it)
+                if (!used[it->second / 2]) next = it->second;
+            if (next == SIZE_MAX) return;
+            used[next / 2] = 1;
+            path.push_back(ends[next ^ 1]);
+        }
+    };
+    std::vector<std::vector<PathPoint>> out;
+    for (size_t s = 0; s < n; s++) {
+        if (used[s]) continue;
+        used[s] = 1;
+        std::vector<PathPoint> path = {ends[2 * s], ends[2 * s + 1]};
+        extend(path);
+        std::reverse(path.begin(), path.end());
+        extend(path);
+        out.push_back(std::move(path));
+    }
+    return out;
+}
+
+// ============================================================================
+// DOKUMEN VEKTOR - ekspor SVG dan PDF
+// ============================================================================
+
+// Records the same calls as Canvas and writes them as vector graphics.
+// Polylines are simplified with simplifyPolyline() at `tolerance` px on the
+// way in. Coordinates are px with y growing downwards; in the PDF one px
+// is one point.
+class VectorDocument {
+public:
+    VectorDocument(int width, int height, Rgb background = {255, 255, 255})
+        : w(width), h(height), background(background) {}
+
+    double tolerance = 0.25;
+
+    int width() const { return w; }
+    int height() const { return h; }
+
+    void line(double x0, double y0, double x1, double y1, Rgb c, float alpha = 1) {
+        polyline({{x0, y0}, {x1, y1}}, c, alpha);
+    }
+
+    void polyline(const std::vector<PathPoint>& pts, Rgb c, float alpha = 1) {
+        if (pts.size() < 2) return;
+        inputPoints += pts.size();
+        Item item{Item::PATH, simplifyPolyline(pts, tolerance), c, alpha, "", 0};
+        outputPoints += item.pts.size();
+        items.push_back(std::move(item));
+    }
+
+    void rect(double x, double y, double width, double height, Rgb c, float alpha = 1) {
+        if (width <= 0 || height <= 0) return;
+        items.push_back({Item::RECT, {{x, y}, {x + width, y + height}}, c, alpha, "", 0});
+    }
+
+    // Monospace text with its top-left corner at (x, y); size is the line
+    // height in px.
+    void text(double x, double y, const std::string& s, int size, Rgb c) {
+        if (!s.empty() && size > 0) items.push_back({Item::TEXT, {{x, y}}, c, 1, s, size});
+    }
+
+    // Courier and the usual monospace fonts advance 0.6 em per character.
+    static int textWidth(const std::string& s, int size) { return int(std::lround(0.6 * size * s.size())); }
+
+    // Polyline points before and after simplification.
+    size_t pointsIn() const { return inputPoints; }
+    size_t pointsOut() const { return outputPoints; }
+
+    bool writeSVG(const std::string& path) const {
+        std::string out;
+        out += "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" + num(w) + "\" height=\"" + num(h) +
+               "\" viewBox=\"0 0 " + num(w) + " " + num(h) + "\">\n";
+        out += "<rect width=\"100%\" height=\"100%\" fill=\"" + hex(background) + "\"/>\n";
+        // Consecutive paths of one style share a single <path> element.
+        for (size_t i = 0; i < items.size();) {
+            const Item& it = items[i];
+            std::string style = " fill=\"" + hex(it.color) + "\"" +
+                                (it.alpha < 1 ? " fill-opacity=\"" + num(it.alpha) + "\"" : "");
+            if (it.kind == Item::RECT) {
+                out += "<rect x=\"" + num(it.pts[0].x) + "\" y=\"" + num(it.pts[0].y) + "\" width=\"" +
+                       num(it.pts[1].x - it.pts[0].x) + "\" height=\"" + num(it.pts[1].y - it.pts[0].y) + "\"" +
+                       style + "/>\n";
+                i++;
+            } else if (it.kind == Item::TEXT) {
+                out += "<text x=\"" + num(it.pts[0].x) + "\" y=\"" + num(it.pts[0].y + 0.8 * it.size) +
+                       "\" font-family=\"monospace\" font-size=\"" + num(it.size) + "\"" + style + ">" +
+                       escapeXml(it.text) + "</text>\n";
+                i++;
+            } else {
+                out += "<path d=\"";
+                size_t j = i;
+                for (; j < items.size() && sameStroke(items[j], it); j++)
+                    for (size_t k = 0; k < items[j].pts.size(); k++)
+                        out += (k ? "L" : "M") + num(items[j].pts[k].x) + " " + num(items[j].pts[k].y);
+                out += "\" fill=\"none\" stroke=\"" + hex(it.color) + "\"" +
+                       (it.alpha < 1 ? " stroke-opacity=\"" + num(it.alpha) + "\"" : "") +
+                       " stroke-width=\"1\" stroke-linejoin=\"round\" stroke-linecap=\"round\"/>\n";
+                i = j;
+            }
+        }
+        out += "</svg>\n";
+        return save(path, out);
+    }
+
+    // Single-page PDF 1.4 with Courier for text. PDF has no opacity
+    // without extended graphics states, so translucent colours are
+    // pre-mixed with the background instead.
+    bool writePDF(const std::string& path) const {
+        std::string content = "1 0 0 -1 0 " + num(h) + " cm 1 w 1 j 1 J\n";
+        content += color(background, 1, "rg") + "0 0 " + num(w) + " " + num(h) + " re f\n";
+        for (const Item& it : items) {
+            if (it.kind == Item::RECT) {
+                content += color(it.color, it.alpha, "rg") + num(it.pts[0].x) + " " + num(it.pts[0].y) + " " +
+                           num(it.pts[1].x - it.pts[0].x) + " " + num(it.pts[1].y - it.pts[0].y) + " re f\n";
+            } else if (it.kind == Item::TEXT) {
+                // Undo the page flip so glyphs stand upright.
+                content += "BT " + color(it.color, 1, "rg") + "/F1 " + num(it.size) + " Tf 1 0 0 -1 " +
+                           num(it.pts[0].x) + " " + num(it.pts[0].y + 0.8 * it.size) + " Tm (" +
+                           escapePdf(it.text) + ") Tj ET\n";
+            } else {
+                content += color(it.color, it.alpha, "RG");
+                for (size_t k = 0; k < it.pts.size(); k++)
+                    content += num(it.pts[k].x) + " " + num(it.pts[k].y) + (k ? " l\n" : " m\n");
+                content += "S\n";
+            }
+        }
+
+        std::vector<std::string> objects = {
+            "<< /Type /Catalog /Pages 2 0 R >>",
+            "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+            "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 " + num(w) + " " + num(h) +
+                "] /Contents 4 0 R /Resources << /Font << /F1 5 0 R >> >> >>",
+            "<< /Length " + std::to_string(content.size()) + " >>\nstream\n" + content + "endstream",
+            "<< /Type /Font /Subtype /Type1 /BaseFont /Courier >>",
+        };
+        std::string out = "%PDF-1.4\n";
+        std::vector<size_t> offsets;
+        for (size_t i = 0; i < objects.size(); i++) {
+            offsets.push_back(out.size());
+            out += std::to_string(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+        }
+        size_t xref = out.size();
+        out += "xref\n0 " + std::to_string(objects.size() + 1) + "\n0000000000 65535 f \n";
+        for (size_t off : offsets) {
+            char entry[24];
+            snprintf(entry, sizeof entry, "%010zu 00000 n \n", off);
+            out += entry;
+        }
+        out += "trailer\n<< /Size " + std::to_string(objects.size() + 1) + " /Root 1 0 R >>\nstartxref\n" +
+               std::to_string(xref) + "\n%%EOF\n";
+        return save(path, out);
+    }
+
+    // PDF for a .pdf path, SVG otherwise.
+    bool write(const std::string& path) const {
+        bool pdf = path.size() >= 4 && path.compare(path.size() - 4, 4, ".pdf") == 0;
+        return pdf ? writePDF(path) : writeSVG(path);
+    }
+
+private:
+    struct Item {
+        enum Kind { PATH, RECT, TEXT } kind;
+        std::vector<PathPoint> pts;  // the path, the two corners, or the text origin
+        Rgb color;
+        float alpha;
+        std::string text;
+        int size;
+    };
+
+    static bool sameStroke(const Item& a, const Item& b) {
+        return a.kind == Item::PATH && b.kind == Item::PATH && a.color.r == b.color.r && a.color.g == b.color.g &&
+               a.color.b == b.color.b && a.alpha == b.alpha;
+    }
+
+    // Shortest form with two decimals, e.g. "12", "0.5", "-3.25".
+    static std::string num(double v) {
+        char buf[32];
+        snprintf(buf, sizeof buf, "%.2f", v);
+        std::string s = buf;
+        s.erase(s.find_last_not_of('0') + 1);
+        if (s.back() == '.') s.pop_back();
+        return s == "-0" ? "0" : s;
+    }
+
+    static std::string hex(Rgb c) {
+        char buf[8];
+        snprintf(buf, sizeof buf, "#%02x%02x%02x", c.r, c.g, c.b);
+        return buf;
+    }
+
+    std::string color(Rgb c, float alpha, const char* op) const {
+        auto mix = [&](uint8_t v, uint8_t bg) { return num((bg + (v - bg) * alpha) / 255.0); };
+        return mix(c.r, background.r) + " " + mix(c.g, background.g) + " " + mix(c.b, background.b) + " " + op + "\n";
+    }
+
+    static std::string escapeXml(const std::string& s) {
+        std::string out;
+        for (char ch : s) {
+            if (ch == '&') out += "&amp;";
+            else if (ch == '<') out += "&lt;";
+            else if (ch == '>') out += "&gt;";
+            else out += ch;
+        }
+        return out;
+    }
+
+    static std::string escapePdf(const std::string& s) {
+        std::string out;
+        for (char ch : s) {
+            if (ch == '\\' || ch == '(' || ch == ')') out += '\\';
+            out += ch;
+        }
+        return out;
+    }
+
+    static bool save(const std::string& path, const std::string& data) {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+        return std::fclose(f) == 0 && ok;
+    }
+
+    int w, h;
+    Rgb background;
+    std::vector<Item> items;
+    size_t inputPoints = 0, outputPoints = 0;
+};